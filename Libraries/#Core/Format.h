@@ -0,0 +1,202 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stdarg.h>
+#include <stdint.h>
+
+/********************************************************************************************************************
+Integer only printf formatter
+	- Replaces vsnprintf, no floating point, no intermediate buffer: every char goes straight to a sink callback
+	- Conversions
+	| %d %i | signed int         | %ld %li | signed long   |
+	| %u    | unsigned int       | %lu     | unsigned long |
+	| %x %X | hex int            | %lx %lX | hex long      |
+	| %c    | char               | %s      | string        |
+	| %%    | percent sign       |         |               |
+	- Width: %5d pads with spaces, %05d / %02X pad with zeros (zeros go after the minus sign)
+	- Values that fit in 16 bit are converted with 16 bit divisions, which are much cheaper than 32 bit ones
+	- Unknown conversions are printed as they are
+*********************************************************************************************************************
+Sink
+	- void sink(void* context, char c), context is passed through unchanged (a UART port, a line counter, etc.)
+	- UART_printf() uses UART_sink, LCDTWI_printf() uses LCDTWI_sink
+********************************************************************************************************************/
+
+typedef void (*FORMAT_sink)(void* context, char c);
+
+/*********************
+Glossary of functions
+*********************/
+uint16_t FORMAT_print (FORMAT_sink sink, void* context, const char* format, ...);
+uint16_t FORMAT_vprint(FORMAT_sink sink, void* context, const char* format, va_list args);
+static uint8_t FORMAT_digits(char* digits, uint32_t value, uint8_t base, uint8_t upper);
+
+/***************************************************
+Function: print()
+Purpose:  Format into a sink
+Input:    Sink, sink context, format, arguments
+Return:   Amount of chars sent to the sink
+***************************************************/
+uint16_t FORMAT_print(FORMAT_sink sink, void* context, const char* format, ...)
+{
+	uint16_t _count;
+	va_list args;
+	va_start(args, format);
+	_count = FORMAT_vprint(sink, context, format, args);
+	va_end(args);
+	return _count;
+}
+
+/***************************************************
+Function: vprint()
+Purpose:  Format into a sink with a va_list
+Input:    Sink, sink context, format, arguments
+Return:   Amount of chars sent to the sink
+***************************************************/
+uint16_t FORMAT_vprint(FORMAT_sink sink, void* context, const char* format, va_list args)
+{
+	char        _digits[11];      // 4294967295 is the longest conversion
+	const char* _s;
+	uint16_t    _count = 0;
+	uint32_t    _value;
+	uint8_t     _length, _width, _zero, _long, _negative, _base;
+	char        _c;
+
+	while ((_c = *format++))
+	{
+		if (_c != '%')
+		{
+			sink(context, _c);
+			_count++;
+			continue;
+		}
+		// Flags, width and length
+		_zero = 0; _width = 0; _long = 0; _negative = 0;
+		if (*format == '0')
+		{
+			_zero = 1;
+			format++;
+		}
+		while (*format >= '0' && *format <= '9')
+			_width = _width * 10 + (*format++ - '0');
+		if (*format == 'l')
+		{
+			_long = 1;
+			format++;
+		}
+		_c = *format++;
+		// Conversion
+		switch (_c)
+		{
+			case 'd':
+			case 'i':
+				if (_long)
+				{
+					long _signed = va_arg(args, long);
+					_negative = (_signed < 0);
+					_value    = _negative ? -(uint32_t)_signed : (uint32_t)_signed;
+				}
+				else
+				{
+					int16_t _signed = va_arg(args, int);
+					_negative = (_signed < 0);
+					_value    = _negative ? (uint16_t)(0U - (uint16_t)_signed) : (uint16_t)_signed;
+				}
+				_base = 10;
+				break;
+			case 'u':
+			case 'x':
+			case 'X':
+				_value = _long ? va_arg(args, unsigned long) : (uint16_t)va_arg(args, unsigned int);
+				_base  = (_c == 'u') ? 10 : 16;
+				break;
+			case 'c':
+				sink(context, (char)va_arg(args, int));
+				_count++;
+				continue;
+			case 's':
+				_s = va_arg(args, const char*);
+				for (_length = 0; _s[_length]; _length++);
+				for (; _width > _length; _width--, _count++)
+					sink(context, ' ');
+				while (*_s)
+				{
+					sink(context, *_s++);
+					_count++;
+				}
+				continue;
+			case '\0':
+				format--; // Format ended right after '%', stop at the terminator
+				continue;
+			default:
+				sink(context, _c);
+				_count++;
+				continue;
+		}
+		// Number: sign, padding, digits
+		_length = FORMAT_digits(_digits, _value, _base, (_c == 'X'));
+		if (_negative)
+		{
+			if (_zero)
+			{
+				sink(context, '-');
+				_count++;
+			}
+			_length++;
+		}
+		for (; _width > _length; _width--, _count++)
+			sink(context, _zero ? '0' : ' ');
+		if (_negative && !_zero)
+		{
+			sink(context, '-');
+			_count++;
+		}
+		if (_negative)
+			_length--;
+		while (_length)
+		{
+			sink(context, _digits[--_length]);
+			_count++;
+		}
+	}
+	return _count;
+}
+
+/***************************************************
+Function: digits()
+Purpose:  Convert a value to digits, least significant first
+Input:    Buffer for the digits, value, base (10 or 16), 1 for upper case hex
+Return:   Amount of digits
+***************************************************/
+static uint8_t FORMAT_digits(char* digits, uint32_t value, uint8_t base, uint8_t upper)
+{
+	const char* _symbols = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	uint8_t     _length  = 0;
+	uint16_t    _short;
+
+	if (base == 16)
+	{
+		// Hex digits are shifts & masks, no division needed
+		do
+		{
+			digits[_length++] = _symbols[value & 0x0F];
+			value >>= 4;
+		}while (value);
+		return _length;
+	}
+	// 32 bit divisions only while the value does not fit in 16 bit
+	while (value > 0xFFFF)
+	{
+		digits[_length++] = '0' + (uint8_t)(value % 10);
+		value /= 10;
+	}
+	_short = (uint16_t)value;
+	do
+	{
+		digits[_length++] = '0' + (uint8_t)(_short % 10);
+		_short /= 10;
+	}while (_short);
+	return _length;
+}
+
+#endif
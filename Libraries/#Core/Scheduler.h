@@ -0,0 +1,166 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "SoftTimer.h"
+
+/********************************************************************************************************************
+Cooperative scheduler
+	- Run to completion: every event handler & soft timer callback runs from SCHEDULER_run() and returns,
+	  nothing is preempted except by ISRs
+	- ISRs post events with SCHEDULER_post(handler, context), the handler later runs in the main loop, e.g.
+		TWI transaction callback:  SCHEDULER_post(sensorRead, transaction);
+		UART RX callback:          SCHEDULER_post(parseCommand, port);   (UART.h with UART_RX_CALLBACK)
+	- Periodic & delayed work uses SoftTimer.h, its timers are checked on every pass
+	- When no event is pending the CPU enters SLEEP_MODE_IDLE, timers, UART & TWI keep running and any interrupt
+	  wakes it, the Timer1 tick (TIMER1_TICK_US) bounds the wake up latency of soft timers
+	- The queue check and the sleep instruction are atomic: an event posted right before sleeping is not missed
+	  (the instruction after sei is always executed before a pending interrupt)
+	- Events are handled in posting order, a full queue drops the new event and counts it
+********************************************************************************************************************/
+
+#ifndef SCHEDULER_QUEUE_SIZE
+	#define SCHEDULER_QUEUE_SIZE 16 // Power of 2, one slot stays free
+#endif
+#define SCHEDULER_QUEUE_MASK (SCHEDULER_QUEUE_SIZE - 1)
+
+#if (SCHEDULER_QUEUE_SIZE & SCHEDULER_QUEUE_MASK) || (SCHEDULER_QUEUE_SIZE > 256)
+	#error "SCHEDULER_QUEUE_SIZE must be a power of 2 up to 256"
+#endif
+
+/*********************************************
+Event
+*********************************************/
+typedef struct
+{
+	void (*handler)(void* context);
+	void*  context;
+}SCHEDULER_event;
+
+/*********************************************
+Scheduler struct
+*********************************************/
+static struct
+{
+	SCHEDULER_event  queue[SCHEDULER_QUEUE_SIZE];
+	volatile uint8_t head, tail;
+	volatile uint16_t dropped;   // Events lost because the queue was full
+}_scheduler;
+
+/*********************************************
+Function prototypes
+*********************************************/
+void     SCHEDULER_begin   (void);
+uint8_t  SCHEDULER_post    (void (*handler)(void* context), void* context);
+uint8_t  SCHEDULER_dispatch(void);
+void     SCHEDULER_run     (void) __attribute__((noreturn));
+uint16_t SCHEDULER_dropped (void);
+
+/*********************************************
+Function: begin()
+Purpose:  Start Timer1, the soft timers and select idle sleep
+Input:    None
+Return:   None
+*********************************************/
+void SCHEDULER_begin(void)
+{
+	TIMER1_begin();
+	SOFTTIMER_begin();
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sei();
+}
+
+/*********************************************
+Function: post()
+Purpose:  Queue an event, safe from ISRs and the main loop
+Input:    Handler, context passed to it
+Return:   1 if queued, 0 if the queue is full
+*********************************************/
+uint8_t SCHEDULER_post(void (*handler)(void* context), void* context)
+{
+	uint8_t _tempHead;
+	uint8_t _queued = 0;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_tempHead = (_scheduler.head + 1) & SCHEDULER_QUEUE_MASK;
+		if (_tempHead == _scheduler.tail)
+		{
+			_scheduler.dropped++;
+		}
+		else
+		{
+			_scheduler.queue[_tempHead].handler = handler;
+			_scheduler.queue[_tempHead].context = context;
+			_scheduler.head = _tempHead;
+			_queued = 1;
+		}
+	}
+	return _queued;
+}
+
+/*********************************************
+Function: dispatch()
+Purpose:  Handle the pending events and expired soft timers once, for loops that do not use SCHEDULER_run()
+Input:    None
+Return:   Amount of events handled
+*********************************************/
+uint8_t SCHEDULER_dispatch(void)
+{
+	SCHEDULER_event _event;
+	uint8_t         _tempTail;
+	uint8_t         _handled = 0;
+
+	while (_scheduler.tail != _scheduler.head)
+	{
+		_tempTail = (_scheduler.tail + 1) & SCHEDULER_QUEUE_MASK;
+		_event    = _scheduler.queue[_tempTail];
+		_scheduler.tail = _tempTail;            // Free the slot before the handler posts again
+		_event.handler(_event.context);
+		_handled++;
+	}
+	SOFTTIMER_run();
+	return _handled;
+}
+
+/*********************************************
+Function: run()
+Purpose:  Event loop, sleeps whenever nothing is pending
+Input:    None
+Return:   Never
+*********************************************/
+void SCHEDULER_run(void)
+{
+	while (1)
+	{
+		SCHEDULER_dispatch();
+		cli();
+		if (_scheduler.tail == _scheduler.head)
+		{
+			sleep_enable();
+			sei();
+			sleep_cpu();
+			sleep_disable();
+		}
+		sei();
+	}
+}
+
+/*********************************************
+Function: dropped()
+Purpose:  Get the amount of events lost because the queue was full
+Input:    None
+Return:   Dropped events
+*********************************************/
+uint16_t SCHEDULER_dropped(void)
+{
+	uint16_t _dropped;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_dropped = _scheduler.dropped;
+	}
+	return _dropped;
+}
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef SOFTTIMER_H
+#define SOFTTIMER_H
+#include <stddef.h>
+#include "Timers.h"
+
+/********************************************************************************************************************
+Software timers on the Timer1 tick
+	- Hashed timer wheel: SOFTTIMER_SLOTS lists, a timer expiring at millis() = t is linked into slot t % SLOTS
+	- Start & stop are O(1) (intrusive singly linked lists with a back link), SOFTTIMER_run() only visits
+	  the slots of the milliseconds that passed instead of every timer
+	- Timers more than SOFTTIMER_SLOTS ms away stay in their slot and are skipped until their turn comes,
+	  more slots = fewer skips, each slot costs one pointer of RAM
+	- Callbacks run from SOFTTIMER_run() in the main loop, never from the ISR, so they can use TWI, UART, etc.
+	- Periodic timers are drift free: the next expiry is the previous expiry + period, not the time the callback ran;
+	  when the main loop falls behind by more than a period the missed calls are skipped, the phase is kept
+	- If the main loop stalls for more than SOFTTIMER_SLOTS ms, every slot is visited once and all overdue timers fire
+	- Timers are owned by the caller (static or global), e.g.
+		void blink(void* context);
+		SOFTTIMER_timer led = {.callback = blink};
+		SOFTTIMER_begin(); SOFTTIMER_start(&led, 500, 500);
+		while (1) SOFTTIMER_run();
+	- A callback may start or stop any timer, itself included
+********************************************************************************************************************/
+
+#ifndef SOFTTIMER_SLOTS
+	#define SOFTTIMER_SLOTS 32 // Power of 2
+#endif
+#define SOFTTIMER_MASK (SOFTTIMER_SLOTS - 1)
+
+#if (SOFTTIMER_SLOTS & SOFTTIMER_MASK)
+	#error "SOFTTIMER_SLOTS is not a power of 2"
+#endif
+
+/*********************************************
+Timer
+*********************************************/
+typedef struct SOFTTIMER_timer
+{
+	struct SOFTTIMER_timer*  next;
+	struct SOFTTIMER_timer** link;        // Pointer pointing at this timer, NULL while stopped
+	unsigned long            expires;     // millis() value
+	unsigned long            period;      // 0 for one-shot
+	void                   (*callback)(void* context);
+	void*                    context;
+}SOFTTIMER_timer;
+
+/*********************************************
+Wheel struct
+*********************************************/
+static struct
+{
+	SOFTTIMER_timer* slots[SOFTTIMER_SLOTS];
+	SOFTTIMER_timer* expiring;               // Slot being processed by SOFTTIMER_run()
+	unsigned long    time;                   // Last millisecond processed
+}_softTimer;
+
+/*********************************************
+Function prototypes
+*********************************************/
+void          SOFTTIMER_begin    (void);
+void          SOFTTIMER_start    (SOFTTIMER_timer* timer, unsigned long delay, unsigned long period);
+void          SOFTTIMER_stop     (SOFTTIMER_timer* timer);
+uint8_t       SOFTTIMER_isActive (const SOFTTIMER_timer* timer);
+unsigned long SOFTTIMER_remaining(const SOFTTIMER_timer* timer);
+void          SOFTTIMER_run      (void);
+static void   SOFTTIMER_insert   (SOFTTIMER_timer* timer);
+static void   SOFTTIMER_remove   (SOFTTIMER_timer* timer);
+
+/*********************************************
+Function: begin()
+Purpose:  Start the wheel at the current time, call after TIMER1_begin()
+Input:    None
+Return:   None
+*********************************************/
+void SOFTTIMER_begin(void)
+{
+	_softTimer.time = millis();
+}
+
+/*********************************************
+Function: start()
+Purpose:  (Re)start a timer, callback & context must be set
+Input:    Timer, ms until the first call, ms between calls (0 for one-shot)
+Return:   None
+*********************************************/
+void SOFTTIMER_start(SOFTTIMER_timer* timer, unsigned long delay, unsigned long period)
+{
+	if (timer->link)
+		SOFTTIMER_remove(timer);
+	timer->expires = millis() + delay;
+	timer->period  = period;
+	SOFTTIMER_insert(timer);
+}
+
+/*********************************************
+Function: stop()
+Purpose:  Stop a timer, does nothing if it is not running
+Input:    Timer
+Return:   None
+*********************************************/
+void SOFTTIMER_stop(SOFTTIMER_timer* timer)
+{
+	if (timer->link)
+		SOFTTIMER_remove(timer);
+}
+
+/*********************************************
+Function: isActive()
+Purpose:  Check if a timer is running
+Input:    Timer
+Return:   1 if running, 0 if stopped or a one-shot already fired
+*********************************************/
+uint8_t SOFTTIMER_isActive(const SOFTTIMER_timer* timer)
+{
+	return timer->link != NULL;
+}
+
+/*********************************************
+Function: remaining()
+Purpose:  Get the time left until a timer expires
+Input:    Timer
+Return:   ms until the next call, 0 if stopped or overdue
+*********************************************/
+unsigned long SOFTTIMER_remaining(const SOFTTIMER_timer* timer)
+{
+	long _left = (long)(timer->expires - millis());
+	return (timer->link && _left > 0) ? (unsigned long)_left : 0;
+}
+
+/*********************************************
+Function: run()
+Purpose:  Call the callbacks of expired timers, call it from the main loop as often as possible
+Input:    None
+Return:   None
+*********************************************/
+void SOFTTIMER_run(void)
+{
+	unsigned long    _now = millis();
+	SOFTTIMER_timer* _timer;
+
+	// After a long stall one revolution is enough to find every overdue timer
+	if (_now - _softTimer.time > SOFTTIMER_SLOTS)
+		_softTimer.time = _now - SOFTTIMER_SLOTS;
+	while (_softTimer.time != _now)
+	{
+		_softTimer.time++;
+		// Move the slot to the expiring list, timers that are not due yet go back into it
+		_softTimer.expiring = _softTimer.slots[_softTimer.time & SOFTTIMER_MASK];
+		if (_softTimer.expiring)
+			_softTimer.expiring->link = &_softTimer.expiring;
+		_softTimer.slots[_softTimer.time & SOFTTIMER_MASK] = NULL;
+		while ((_timer = _softTimer.expiring))
+		{
+			SOFTTIMER_remove(_timer);
+			if ((long)(_timer->expires - _softTimer.time) > 0)
+			{
+				SOFTTIMER_insert(_timer); // Later revolution
+				continue;
+			}
+			if (_timer->period)
+			{
+				// Keep the phase, skip the calls that were missed
+				do
+				{
+					_timer->expires += _timer->period;
+				}while ((long)(_timer->expires - _softTimer.time) <= 0);
+				SOFTTIMER_insert(_timer);
+			}
+			_timer->callback(_timer->context);
+		}
+	}
+}
+
+/*********************************************
+Function: insert()
+Purpose:  Link a timer into the slot of its expiry time
+Input:    Timer
+Return:   None
+*********************************************/
+static void SOFTTIMER_insert(SOFTTIMER_timer* timer)
+{
+	SOFTTIMER_timer** _slot;
+
+	// Already due: the next processed millisecond picks it up instead of a full revolution later
+	if ((long)(timer->expires - _softTimer.time) > 0)
+		_slot = &_softTimer.slots[timer->expires & SOFTTIMER_MASK];
+	else
+		_slot = &_softTimer.slots[(_softTimer.time + 1) & SOFTTIMER_MASK];
+	timer->next = *_slot;
+	if (timer->next)
+		timer->next->link = &timer->next;
+	timer->link = _slot;
+	*_slot      = timer;
+}
+
+/*********************************************
+Function: remove()
+Purpose:  Unlink a timer from its list
+Input:    Timer
+Return:   None
+*********************************************/
+static void SOFTTIMER_remove(SOFTTIMER_timer* timer)
+{
+	*timer->link = timer->next;
+	if (timer->next)
+		timer->next->link = timer->link;
+	timer->link = NULL;
+}
+
+#endif
@@ -1,44 +1,263 @@
 #ifndef STRING_H
 #define STRING_H
-// In work... //
+#include <stddef.h>
+#include <stdint.h>
+#include "Format.h"
 
-char*   mystrcat(char* destination, char* source, size_t size);
-void*   mymemset(void* array, const uint8_t value);
-int8_t  mystrcmp(const char* array1, const char* array2, size_t size);
-uint8_t mystrlen(const char* array);
+/********************************************************************************************************************
+Bounded string routines
+	- size is always the size of the whole destination buffer, the result is always null terminated
+	- mystrlcat & mystrappend return the length the string would have without truncation (like strlcat),
+	  a result >= size means the source did not fit
+	- mystrappend takes the current length instead of scanning for it, appending one char is O(1), e.g.
+		char    buffer[10];
+		uint8_t length = 0;
+		length = mystrappend(buffer, length, &key, 1, sizeof buffer);
+	- mystrncmp compares at most size chars and stops at the first difference or terminator (strncmp semantics)
+	- AVR has an 8 bit data path, the loops use post incremented pointers (ld/st X+) which is already one byte
+	  per instruction, word sized copies would not be faster
+*********************************************************************************************************************
+String builder
+	- STRING_builder keeps buffer, size & length together, every append is O(chars appended), nothing is rescanned
+	- Buffers up to 255 bytes, LCD lines & UART messages, STRING_BUILDER() of a larger array does not compile
+	- STRING_BUILDER() is a constant initializer and does not touch the buffer: call STRING_clear() before the
+	  first append (STRING_init() does it), data is only a valid string after that
+	- Chars that do not fit are dropped and overflow is set, the buffer is always null terminated
+	- Numbers are converted with FORMAT_digits (Format.h), no format string is parsed
+	- STRING_flush() sends the content to any Format.h sink and empties the builder, e.g.
+		char           text[21];
+		STRING_builder line = STRING_BUILDER(text);
+		STRING_clear(&line);
+		STRING_appendText(&line, "T: "); STRING_appendPadded(&line, temperature, 3, ' '); STRING_append(&line, 'C');
+		STRING_flush(&line, LCDTWI_sink, NULL);    // or UART_sink, UART0
+	- STRING_printf() appends printf style text for the rare cases the appends do not cover
+********************************************************************************************************************/
 
-char* mystrcat(char* destination, char* source, size_t size)
+size_t mystrlen   (const char* array);
+size_t mystrlcat  (char* destination, const char* source, size_t size);
+size_t mystrappend(char* destination, size_t length, const char* source, size_t count, size_t size);
+void*  mymemset   (void* array, uint8_t value, size_t size);
+int    mystrncmp  (const char* array1, const char* array2, size_t size);
+
+typedef struct
+{
+    char*   data;     // Caller's buffer
+    uint8_t size;     // Buffer size, the null included
+    uint8_t length;   // Chars in the buffer
+    uint8_t overflow; // 1 once a char did not fit
+}STRING_builder;
+
+// The array size term fails to compile (negative size) for buffers over 255 bytes
+#define STRING_BUILDER(buffer) {.data = (buffer), .length = 0, .overflow = 0,                                    \
+                                .size = sizeof(buffer) + 0 * sizeof(char[(sizeof(buffer) <= 255) ? 1 : -1])}
+
+void    STRING_init         (STRING_builder* builder, char* buffer, uint8_t size);
+void    STRING_clear        (STRING_builder* builder);
+void    STRING_append       (STRING_builder* builder, char c);
+void    STRING_appendText   (STRING_builder* builder, const char* text);
+void    STRING_appendDecimal(STRING_builder* builder, long value);
+void    STRING_appendHex    (STRING_builder* builder, unsigned long value, uint8_t digits);
+void    STRING_appendPadded (STRING_builder* builder, long value, uint8_t width, char pad);
+void    STRING_printf       (STRING_builder* builder, const char* format, ...);
+void    STRING_sink         (void* builder, char c);
+uint8_t STRING_flush        (STRING_builder* builder, FORMAT_sink sink, void* context);
+
+size_t mystrlen(const char* array)
+{
+    const char* pointer = array; // Point to the first char
+    while (*pointer)             // While not a null
+        pointer++;               // Move to the next char
+    return pointer - array;      // Return the length
+}
+
+size_t mystrlcat(char* destination, const char* source, size_t size)
+{
+    size_t length = 0;
+    while (length < size && destination[length]) // Find the end, never past the buffer
+        length++;
+    if (length == size)                           // Destination is not terminated, nothing fits
+        return length + mystrlen(source);
+    return mystrappend(destination, length, source, mystrlen(source), size);
+}
+
+size_t mystrappend(char* destination, size_t length, const char* source, size_t count, size_t size)
 {
-    char* pointer = destination + mystrlen(destination); // Point to the destination string
-    while (size--)                                       // Concatenate the char into the string
-		*pointer++ = *source++;                          // Update destination pointer with source pointer
-    *pointer = '\0';                                     // Null terminate the pointer
-    return destination;                                  // Return the destination string
+    size_t total = length + count;                 // Length without truncation
+    char*  pointer = destination + length;         // Point to the end of the destination string
+    if (length >= size)                            // No room at all, not even for the null
+        return total;
+    if (count > size - 1 - length)                 // Copy only what fits with the null
+        count = size - 1 - length;
+    while (count--)                                // Concatenate the chars into the string
+        *pointer++ = *source++;
+    *pointer = '\0';                               // Null terminate the string
+    return total;                                  // Return the new length
 }
 
-void* mymemset(void* array, const uint8_t value)
+void* mymemset(void* array, uint8_t value, size_t size)
 {
-    uint8_t* pointer = array;        // Point to the address of array
-    while (*pointer)                 // While not a null
-        *pointer++ = (uint8_t)value; // Put value into address
-    return array;                    // Return the array
+    uint8_t* pointer = array; // Point to the address of array
+    while (size--)            // For every byte
+        *pointer++ = value;   // Put value into address
+    return array;             // Return the array
 }
 
-int8_t mystrcmp(const char* array1, const char* array2, size_t size)
+int mystrncmp(const char* array1, const char* array2, size_t size)
 {
-    while(*array1++ == *array2++) // While array elements are equal
-    --size;                       // Get n closer to 0
-    if (size == 0)
-    return 0;                     // Return 0 if both arrays are equal
-    return 1;                     // Return 1 if arrays are different
+    for (; size; size--, array1++, array2++)
+    {
+        if (*array1 != *array2)                                  // First difference decides
+            return (uint8_t)*array1 - (uint8_t)*array2;
+        if (*array1 == '\0')                                     // Both strings ended together
+            return 0;
+    }
+    return 0;                                                    // Equal for size chars
 }
 
-uint8_t mystrlen(const char* array)
+/*********************************************
+Function: init()
+Purpose:  Attach an empty builder to a buffer
+Input:    Builder, buffer, buffer size (at least 1)
+Return:   None
+*********************************************/
+void STRING_init(STRING_builder* builder, char* buffer, uint8_t size)
 {
-    uint8_t length = 0; // Set length to 0 by default
-    while(*array++)     // While not a null
-        length++;       // Increase the length
-    return length;      // Return the length
+    builder->data = buffer;
+    builder->size = size;
+    STRING_clear(builder);
+}
+
+/*********************************************
+Function: clear()
+Purpose:  Empty the builder
+Input:    Builder
+Return:   None
+*********************************************/
+void STRING_clear(STRING_builder* builder)
+{
+    builder->length   = 0;
+    builder->overflow = 0;
+    builder->data[0]  = '\0';
+}
+
+/*********************************************
+Function: append()
+Purpose:  Append one char
+Input:    Builder, char
+Return:   None
+*********************************************/
+void STRING_append(STRING_builder* builder, char c)
+{
+    if (builder->length + 1 >= builder->size) // Keep room for the null
+    {
+        builder->overflow = 1;
+        return;
+    }
+    builder->data[builder->length++] = c;
+    builder->data[builder->length]   = '\0';
+}
+
+/*********************************************
+Function: appendText()
+Purpose:  Append a null terminated string
+Input:    Builder, string
+Return:   None
+*********************************************/
+void STRING_appendText(STRING_builder* builder, const char* text)
+{
+    while (*text)
+        STRING_append(builder, *text++);
+}
+
+/*********************************************
+Function: appendDecimal()
+Purpose:  Append a signed decimal number
+Input:    Builder, value
+Return:   None
+*********************************************/
+void STRING_appendDecimal(STRING_builder* builder, long value)
+{
+    STRING_appendPadded(builder, value, 0, ' ');
+}
+
+/*********************************************
+Function: appendHex()
+Purpose:  Append an upper case hex number, zero padded
+Input:    Builder, value, minimum amount of digits
+Return:   None
+*********************************************/
+void STRING_appendHex(STRING_builder* builder, unsigned long value, uint8_t digits)
+{
+    char    _digits[8];
+    uint8_t _length = FORMAT_digits(_digits, value, 16, 1);
+
+    for (; digits > _length; digits--)
+        STRING_append(builder, '0');
+    while (_length)
+        STRING_append(builder, _digits[--_length]);
+}
+
+/*********************************************
+Function: appendPadded()
+Purpose:  Append a signed decimal number right aligned in a field
+Input:    Builder, value, field width, pad char ('0' pads after the minus sign)
+Return:   None
+*********************************************/
+void STRING_appendPadded(STRING_builder* builder, long value, uint8_t width, char pad)
+{
+    char    _digits[10];
+    uint8_t _negative = (value < 0);
+    uint8_t _length   = FORMAT_digits(_digits, _negative ? -(uint32_t)value : (uint32_t)value, 10, 0);
+
+    if (_negative && pad == '0')
+        STRING_append(builder, '-');
+    for (; width > _length + _negative; width--)
+        STRING_append(builder, pad);
+    if (_negative && pad != '0')
+        STRING_append(builder, '-');
+    while (_length)
+        STRING_append(builder, _digits[--_length]);
+}
+
+/*********************************************
+Function: printf()
+Purpose:  Append formatted text (Format.h conversions)
+Input:    Builder, format, arguments
+Return:   None
+*********************************************/
+void STRING_printf(STRING_builder* builder, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    FORMAT_vprint(STRING_sink, builder, format, args);
+    va_end(args);
+}
+
+/*********************************************
+Function: sink()
+Purpose:  Formatter sink, append one char to a builder
+Input:    Builder, char
+Return:   None
+*********************************************/
+void STRING_sink(void* builder, char c)
+{
+    STRING_append((STRING_builder*)builder, c);
+}
+
+/*********************************************
+Function: flush()
+Purpose:  Send the content to a sink and empty the builder
+Input:    Builder, sink (LCDTWI_sink, UART_sink, ...), sink context
+Return:   Amount of chars sent
+*********************************************/
+uint8_t STRING_flush(STRING_builder* builder, FORMAT_sink sink, void* context)
+{
+    uint8_t _length = builder->length;
+
+    for (uint8_t i = 0; i < _length; i++)
+        sink(context, builder->data[i]);
+    STRING_clear(builder);
+    return _length;
 }
 
 #endif
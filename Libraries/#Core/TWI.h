@@ -1,9 +1,13 @@
 #ifndef TWI_H
 #define TWI_H
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+#include <util/twi.h>
 
 /********************************************************************************************************************
-Revision 1.1
+Revision 1.2
 ADDRESS: 0x68 (MPU 6050)
 0x68 = 0b01101000
 Slave write address: (Address << 1) | 0 = 0xD0
@@ -11,57 +15,419 @@ Slave read address: (Address << 1) | 1 = 0xD1
 *********************************************************************************************************************
 TWBR - TWI Bit Rate Register
 	 - Used to generate SCL frequency while in master mode
+	 - SCL = F_CPU / (16 + 2 * TWBR * 4^TWPS)
+	 - TWI_begin() picks the smallest prescaler (TWPS) that fits TWBR in 8 bits and rounds TWBR up,
+	   so the achieved SCL frequency never exceeds the requested one
+	 - With a constant frequency everything is folded at compile time and an unreachable frequency is a compile error
 *********************************************************************************************************************
 TWCR - TWI Control Register
 	 - Used to control events of all I2C communications
 TWCR BITMASK
 | BIT 7 | BIT 6 | BIT 5 | BIT 4 | BIT 3 | BIT 2 | BIT 1 | BIT 0 |
 | TWINT | TWEA  | TWSTA | TWSTO | TWWC  | TWEN  |   -   | TWIE  |
+*********************************************************************************************************************
+TWSR - TWI Status Register
+	 - Bits 7..3 hold the status of the last bus event (see <util/twi.h>), bits 1..0 hold the prescaler
+*********************************************************************************************************************
+Transaction engine
+	 - Every bus access is described by a TWI_transaction (address, write buffer, read buffer, callback)
+	 - Transactions are queued with TWI_submit() and executed in the background by TWI_vect
+	 - A transaction with a write and a read phase uses a repeated START between them
+	 - TWI_readRegisters()/TWI_writeRegisters() move a block of consecutive registers in a single transaction
+	 - TWI_beginTransmission()/TWI_write()/TWI_requestFrom()/TWI_read()/TWI_endTransmission() are a blocking
+	   wrapper around the engine and wait for the queued transaction to complete
+	 - The wrapper buffers up to TWI_BUFFER_SIZE bytes, writing more fails and the transmission is not sent at all
+	   (endTransmission()/requestFrom() return TWI_ERROR_OVERFLOW), a truncated write would corrupt the slave
+	 - requestFrom() of more than TWI_BUFFER_SIZE bytes and writeRegisters() of more than TWI_BUFFER_SIZE - 1
+	   registers return TWI_ERROR_OVERFLOW without a transfer
+	 - Every TWSR status is checked, unexpected ones complete the transaction with an error
+	 - Blocking calls give up when the bus shows no activity for TWI_TIMEOUT_BYTES byte times and run TWI_recover()
+*********************************************************************************************************************
+Multi-master
+	 - A master that loses arbitration (TW_MT_ARB_LOST) releases the bus without corrupting the winner's transfer
+	 - The transaction is restarted from its first byte with TWSTA set, the hardware holds the START back until
+	   the winning master sends its STOP, which serializes the masters without software delays
+	 - After TWI_ARBITRATION_RETRIES lost arbitrations the transaction fails with TWI_ERROR_ARBITRATION
+	 - While the START is held back the blocking calls do not count idle time, the winner's transfer can be long
+	 - TWI_statistics counts lost arbitrations, retries, completed transactions and the SCL clocks they used,
+	   bus utilization = clocks / (TWI_getFrequency() * elapsed seconds)
+*********************************************************************************************************************
+Bus scan
+	 - TWI_scan() probes every address from 0x08 to 0x77 with an empty write and a short timeout
+	 - Acknowledged addresses are cached in a presence bitmap, TWI_isPresent() reads it
+	 - Once scanned, transactions for absent addresses complete at once with TWI_ERROR_ABSENT without touching the bus
+*********************************************************************************************************************
+Bus clear
+	 - A slave interrupted in the middle of a read can hold SDA low forever
+	 - TWI_recover() releases the pins from TWI and, only when SDA is held low, clocks SCL up to 9 times until SDA
+	   is released and sends a STOP (a STOP forced on a free bus would corrupt another master's transfer)
+*********************************************************************************************************************
+TWAR - TWI (Slave) Address Register
+TWAR BITMASK
+| BIT 7 | BIT 6 | BIT 5 | BIT 4 | BIT 3 | BIT 2 | BIT 1 | BIT 0 |
+| TWA6  | TWA5  | TWA4  | TWA3  | TWA2  | TWA1  | TWA0  | TWGCE |
+TWA6..0 - Own slave address
+TWGCE   - General call recognition enable
+*********************************************************************************************************************
+Slave mode
+	 - TWI_beginSlave() answers on the own address (and general call) with a register map of up to 255 bytes
+	 - The first byte written by a master sets the register pointer, next bytes are written to the registers
+	 - Reads start at the register pointer, the pointer increments after every byte and wraps at the end of the map
+	 - The map is double buffered: the master reads the front snapshot while the application fills the back one
+	   returned by TWI_slaveRegisters() and publishes it with TWI_slaveCommit()
+	 - A commit during a slave transfer is applied when the transfer ends, so multi byte values are never torn
+	 - Master transactions queued while addressed as slave start when the slave transfer ends
 *********************************************************************************************************************/
 
 #if defined(__AVR_ATmega16__) || defined(__AVR_ATmega16A__)
 	#define TWI_DDR  DDRC
 	#define TWI_PORT PORTC
+	#define TWI_PIN  PINC
 	#define TWI_SCL  PORTC0
 	#define TWI_SDA  PORTC1
 #endif
 
-#define TWI_START()     (TWCR = (1<<TWINT)|(1<<TWEN)|(1<<TWSTA))
-#define TWI_STOP()      (TWCR = (1<<TWINT)|(1<<TWEN)|(1<<TWSTO))
-#define TWI_WRITE()     (TWCR = (1<<TWINT)|(1<<TWEN))
-#define TWI_READ(ACK)   (TWCR = (1<<TWINT)|(1<<TWEN)|(ACK<<TWEA))
+#define TWI_START()     (TWCR = (1<<TWINT)|(1<<TWEN)|(1<<TWIE)|(1<<TWSTA)|_twi.acknowledge)
+#define TWI_STOP()      (TWCR = (1<<TWINT)|(1<<TWEN)|(1<<TWIE)|(1<<TWSTO)|_twi.acknowledge)
+#define TWI_RESTART()   (TWCR = (1<<TWINT)|(1<<TWEN)|(1<<TWIE)|(1<<TWSTO)|(1<<TWSTA)|_twi.acknowledge)
+#define TWI_WRITE()     (TWCR = (1<<TWINT)|(1<<TWEN)|(1<<TWIE)|_twi.acknowledge)
+#define TWI_READ(ACK)   (TWCR = (1<<TWINT)|(1<<TWEN)|(1<<TWIE)|((ACK)<<TWEA))
+#define TWI_RELEASE()   (TWCR = (1<<TWINT)|(1<<TWEN)|(1<<TWIE)|_twi.acknowledge)
+
+#define F_TWI_100K 100000UL
+#define F_TWI_250K 250000UL
+#define F_TWI_400K 400000UL
 
-#define F_TWI_100K 72
-#define F_TWI_250K 24
-#define F_TWI_400K 12
+#define TWI_CYCLES(frequency)             ((F_CPU + (frequency) - 1) / (frequency))                                 // CPU cycles per SCL period (rounded up)
+#define TWI_BIT_RATE(frequency, prescale) ((TWI_CYCLES(frequency) - 16 + 2 * (prescale) - 1) / (2 * (prescale))) // TWBR for a prescaler (rounded up)
+#define TWI_PRESCALER(frequency)          ((TWI_BIT_RATE(frequency, 1)  <= 255) ? 0 : \
+                                           (TWI_BIT_RATE(frequency, 4)  <= 255) ? 1 : \
+                                           (TWI_BIT_RATE(frequency, 16) <= 255) ? 2 : 3)                          // TWPS bits
+#define TWI_REACHABLE(frequency)          ((frequency) && TWI_CYCLES(frequency) >= 16 && TWI_BIT_RATE(frequency, 64) <= 255)
 
-static int8_t _bytes;
+#define TWI_QUEUE_SIZE          8  // Transactions waiting for the bus
+#define TWI_BUFFER_SIZE         32 // Bytes buffered by the blocking wrapper
+#define TWI_TIMEOUT_BYTES       16 // Byte times without bus activity before a blocking call gives up
+#define TWI_ARBITRATION_RETRIES 8  // Lost arbitrations before a transaction fails
+#define TWI_SCAN_TIMEOUT_BYTES  2  // Byte times without bus activity before a scan probe gives up
+#define TWI_SCAN_FIRST          0x08 // First address probed by TWI_scan() (0x00 - 0x07 are reserved)
+#define TWI_SCAN_LAST           0x77 // Last address probed by TWI_scan() (0x78 - 0x7F are reserved)
+
+#define TWI_QUEUE_MASK (TWI_QUEUE_SIZE - 1) // Used to mask queue index within 0 and (queue size - 1)
+
+#if (TWI_QUEUE_SIZE & TWI_QUEUE_MASK)
+	#error "TWI queue size is not a power of 2"
+#endif
+
+// Transaction status
+// ******************************************************************************************************************
+#define TWI_OK                ((uint8_t)0x00) // Transaction completed
+#define TWI_PENDING           ((uint8_t)0x01) // Transaction queued or in progress
+#define TWI_ERROR_NACK        ((uint8_t)0x02) // Slave did not acknowledge address or data
+#define TWI_ERROR_BUS         ((uint8_t)0x03) // Illegal START/STOP detected on the bus
+#define TWI_ERROR_ARBITRATION ((uint8_t)0x04) // Arbitration lost to another master
+#define TWI_ERROR_TIMEOUT     ((uint8_t)0x05) // No bus activity for too long, bus was recovered
+#define TWI_ERROR_ABSENT      ((uint8_t)0x06) // Address not found by the last TWI_scan(), bus not touched
+#define TWI_ERROR_OVERFLOW    ((uint8_t)0x07) // More than TWI_BUFFER_SIZE bytes written or requested, bus not touched
+
+/*********************************************
+Transaction descriptor
+*********************************************/
+typedef struct TWI_transaction
+{
+	uint8_t           address;                              // 7 bit slave address
+	const uint8_t*    writeBuffer;                          // Bytes sent after SLA+W
+	uint8_t           writeLength;                          // Amount of bytes to send (0 skips the write phase)
+	uint8_t*          readBuffer;                           // Bytes received after SLA+R
+	uint8_t           readLength;                           // Amount of bytes to receive (0 skips the read phase)
+	void              (*callback)(struct TWI_transaction*); // Called from TWI_vect when completed (optional)
+	volatile uint8_t  status;                               // TWI_PENDING until completed
+	volatile uint16_t clocks;                               // SCL clocks the bus was busy for this transaction
+	volatile uint8_t  retries;                              // Restarts after lost arbitration
+}TWI_transaction;
+
+/*********************************************
+Bus statistics
+*********************************************/
+typedef struct
+{
+	uint16_t nack;         // Transactions not acknowledged
+	uint16_t bus;          // Bus errors and unexpected status codes
+	uint16_t arbitration;  // Arbitrations lost
+	uint16_t retry;        // Transactions restarted after lost arbitration
+	uint16_t timeout;      // Transactions aborted by timeout
+	uint16_t recovery;     // Bus clear sequences
+	uint16_t transactions; // Transactions completed (successful or not)
+	uint32_t clocks;       // SCL clocks used by completed transactions
+}TWI_statistics;
+
+/*********************************************
+TWI struct
+*********************************************/
+static struct
+{
+	TWI_transaction* volatile queue[TWI_QUEUE_SIZE];
+	volatile uint8_t head, tail, busy, events;
+	volatile uint8_t waiting;                                // START held back until another master frees the bus
+	uint8_t index, reading;
+	uint32_t frequency;
+	uint32_t timeout;
+	TWI_statistics statistics;
+	TWI_transaction transaction;
+	uint8_t address, length, pending, overflow;
+	uint8_t txBuffer[TWI_BUFFER_SIZE];
+	uint8_t rxBuffer[TWI_BUFFER_SIZE];
+	uint8_t rxIndex, rxLength;
+	uint8_t acknowledge;
+	uint8_t scanned, present[16];
+}_twi;
+
+/*********************************************
+TWI slave struct
+*********************************************/
+static struct
+{
+	uint8_t* registers[2];                       // Front and back snapshot of the register map
+	uint8_t  size, pointer, first;
+	volatile uint8_t front, pending, synced, active;
+	void     (*callback)(uint8_t reg, uint8_t data); // Called from TWI_vect when a master writes a register
+}_twiSlave;
 
 /*********************************************
 Function prototypes
 *********************************************/
-uint8_t TWI_begin(uint8_t speed);
-void    TWI_beginTransmission(uint8_t address);
-void    TWI_write(uint8_t data);
-void    TWI_requestFrom(uint8_t address, uint8_t bytes);
-uint8_t TWI_read();
-void    TWI_endTransmission();
-static uint8_t handleSpeed(uint8_t speed);
+static inline uint32_t TWI_begin(uint32_t frequency) __attribute__((always_inline));
+uint32_t TWI_getFrequency(void);
+uint8_t  TWI_submit(TWI_transaction* transaction);
+uint8_t  TWI_transfer(TWI_transaction* transaction);
+uint8_t  TWI_isBusy(void);
+uint32_t TWI_busyTime(const TWI_transaction* transaction);
+void     TWI_recover(void);
+uint8_t  TWI_scan(void);
+uint8_t  TWI_isPresent(uint8_t address);
+void     TWI_getStatistics(TWI_statistics* statistics);
+void     TWI_clearStatistics(void);
+void     TWI_beginTransmission(uint8_t address);
+uint8_t  TWI_write(uint8_t data);
+uint8_t  TWI_requestFrom(uint8_t address, uint8_t bytes);
+uint8_t  TWI_read();
+uint8_t  TWI_endTransmission();
+uint8_t  TWI_readRegisters(uint8_t address, uint8_t reg, uint8_t* data, uint8_t size);
+uint8_t  TWI_writeRegisters(uint8_t address, uint8_t reg, const uint8_t* data, uint8_t size);
+void     TWI_beginSlave(uint8_t address, uint8_t generalCall, uint8_t* registers, uint8_t size, void (*callback)(uint8_t reg, uint8_t data));
+uint8_t* TWI_slaveRegisters(void);
+void     TWI_slaveCommit(void);
+static uint32_t TWI_configure(uint8_t bitRate, uint8_t prescaler);
+extern void    TWI_frequencyUnreachable(void) __attribute__((error("TWI frequency cannot be reached with this F_CPU")));
+static void    TWI_handleInterrupt(void);
+static void    TWI_complete(uint8_t status, uint8_t stop);
+static void    TWI_handleSlave(uint8_t status);
+static void    TWI_slaveEnd(void);
+static uint8_t TWI_wait(TWI_transaction* transaction, uint32_t timeout);
+static void    TWI_watchdog(uint8_t* events, uint32_t* idle, uint32_t timeout);
+static void    TWI_busClear(void);
+
+/*********************************************
+Function: Interrupt Service Routine
+Purpose:  Advance the transaction in progress
+Input:    Interrupt vector
+Return:   None
+*********************************************/
+ISR (TWI_vect)
+{
+	TWI_handleInterrupt();
+}
 
 /*********************************************
 Function: begin()
 Purpose:  Initialize TWI
+Input:    SCL frequency in Hz (F_TWI_100K, F_TWI_400K, etc.)
+Return:   Achieved SCL frequency in Hz or 0 if the frequency cannot be reached
+*********************************************/
+static inline uint32_t TWI_begin(uint32_t frequency)
+{
+	uint8_t prescaler;
+	if (__builtin_constant_p(frequency) && !TWI_REACHABLE(frequency))
+		TWI_frequencyUnreachable();
+	if (!TWI_REACHABLE(frequency))
+		return 0;
+	prescaler = TWI_PRESCALER(frequency);
+	return TWI_configure(TWI_BIT_RATE(frequency, 1UL << (2 * prescaler)), prescaler);
+}
+
+/*********************************************
+Function: getFrequency()
+Purpose:  Get the achieved SCL frequency
 Input:    None
-Return:   1 if successful or loop endlessly if unsuccesful
+Return:   SCL frequency in Hz
 *********************************************/
-uint8_t TWI_begin(uint8_t speed)
+uint32_t TWI_getFrequency(void)
 {
-	TWI_DDR  &= ~(1 << TWI_SDA) | (1 << TWI_SCL);
-	TWI_PORT &= ~(1 << TWI_SDA) | (1 << TWI_SCL);
-	while (!handleSpeed(speed));
+	return _twi.frequency;
+}
+
+/*********************************************
+Function: submit()
+Purpose:  Queue a transaction for the background engine
+Input:    Transaction descriptor (must stay valid until completed)
+Return:   1 if queued (or completed at once for an absent address) and 0 if the queue is full
+*********************************************/
+uint8_t TWI_submit(TWI_transaction* transaction)
+{
+	uint8_t _tempHead;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (!TWI_isPresent(transaction->address))     // Fail fast without touching the bus
+		{
+			transaction->status = TWI_ERROR_ABSENT;
+			if (transaction->callback)
+				transaction->callback(transaction);
+			return 1;
+		}
+		_tempHead = (_twi.head + 1) & TWI_QUEUE_MASK;
+		if (_tempHead == _twi.tail)
+			return 0;
+		transaction->status  = TWI_PENDING;
+		transaction->clocks  = 0;
+		transaction->retries = 0;
+		_twi.queue[_tempHead] = transaction;
+		_twi.head = _tempHead;
+		if (!_twi.busy)
+		{
+			_twi.busy = 1;
+			if (!_twiSlave.active && !(TWCR & (1 << TWINT))) // Otherwise started when the slave transfer ends
+				TWI_START();
+		}
+	}
 	return 1;
 }
 
+/*********************************************
+Function: transfer()
+Purpose:  Queue a transaction and wait for it to complete
+Input:    Transaction descriptor
+Return:   Status of the transaction
+*********************************************/
+uint8_t TWI_transfer(TWI_transaction* transaction)
+{
+	return TWI_wait(transaction, _twi.timeout);
+}
+
+/*********************************************
+Function: isBusy()
+Purpose:  Check if the engine is working on the queue
+Input:    None
+Return:   1 if busy and 0 if idle
+*********************************************/
+uint8_t TWI_isBusy(void)
+{
+	return _twi.busy;
+}
+
+/*********************************************
+Function: busyTime()
+Purpose:  Get the time a completed transaction kept the bus busy
+Input:    Transaction descriptor
+Return:   Bus busy time in microseconds, 0 before TWI_begin()
+*********************************************/
+uint32_t TWI_busyTime(const TWI_transaction* transaction)
+{
+	uint32_t scaled = (uint32_t)transaction->clocks * 10000UL; // clocks * 1000000 / frequency without overflow
+
+	if (!_twi.frequency)
+		return 0;
+	if (_twi.frequency < 100UL)                  // Slow SCL, e.g. TWBR 255 & prescaler 64 at 1 MHz
+		return scaled / _twi.frequency * 100UL;
+	return scaled / (_twi.frequency / 100UL);
+}
+
+/*********************************************
+Function: recover()
+Purpose:  Abort the transaction in progress, clear the bus and continue with the queue
+Input:    None
+Return:   None
+*********************************************/
+void TWI_recover(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		TWI_busClear();
+		TWCR = (1 << TWEN) | (1 << TWIE) | _twi.acknowledge;
+		_twiSlave.active = 0;
+		_twi.waiting     = 0;
+		if (_twi.busy)
+			TWI_complete(TWI_ERROR_TIMEOUT, 0);
+	}
+}
+
+/*********************************************
+Function: scan()
+Purpose:  Probe every address and cache which devices answer
+Input:    None
+Return:   Amount of devices found
+*********************************************/
+uint8_t TWI_scan(void)
+{
+	uint8_t address, found = 0;
+	uint32_t timeout = (_twi.timeout / TWI_TIMEOUT_BYTES) * TWI_SCAN_TIMEOUT_BYTES;
+	TWI_transaction probe = {0};
+	_twi.scanned = 0;                                 // Probe every address, even the ones missing last time
+	for (address = 0; address < sizeof _twi.present; address++)
+		_twi.present[address] = 0;
+	for (address = TWI_SCAN_FIRST; address <= TWI_SCAN_LAST; address++)
+	{
+		probe.address = address;                      // SLA+W followed by STOP
+		if (TWI_wait(&probe, timeout) == TWI_OK)
+		{
+			_twi.present[address >> 3] |= (1 << (address & 7));
+			found++;
+		}
+	}
+	_twi.scanned = 1;
+	return found;
+}
+
+/*********************************************
+Function: isPresent()
+Purpose:  Check the presence cache built by scan()
+Input:    Address of the slave
+Return:   1 if present or no scan was done yet and 0 if absent
+*********************************************/
+uint8_t TWI_isPresent(uint8_t address)
+{
+	if (!_twi.scanned)
+		return 1;
+	return (_twi.present[(address >> 3) & 0x0F] >> (address & 7)) & 1;
+}
+
+/*********************************************
+Function: getStatistics()
+Purpose:  Get a snapshot of the bus statistics
+Input:    Pointer to statistics
+Return:   None
+*********************************************/
+void TWI_getStatistics(TWI_statistics* statistics)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		*statistics = _twi.statistics;
+	}
+}
+
+/*********************************************
+Function: clearStatistics()
+Purpose:  Reset the bus statistics
+Input:    None
+Return:   None
+*********************************************/
+void TWI_clearStatistics(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_twi.statistics = (TWI_statistics){0};
+	}
+}
+
 /*********************************************
 Function: beginTransmission()
 Purpose:  Begin transmission of data
@@ -70,42 +436,53 @@ Return:   None
 *********************************************/
 void TWI_beginTransmission(uint8_t address)
 {
-	TWI_START();
-	while (!(TWCR & (1 << TWINT)));
-	address = (address << 1);
-	TWDR = address;
-	TWI_WRITE();
-	while (!(TWCR & (1 << TWINT)));
+	_twi.address  = address;
+	_twi.length   = 0;
+	_twi.pending  = 1;
+	_twi.overflow = 0;
 }
 
 /*********************************************
 Function: write() | (old writeData())
 Purpose:  Write data on the TWI bus
 Input:    Byte of data to be sent
-Return:   None
+Return:   1 if buffered and 0 if the buffer is full (the whole transmission fails)
 *********************************************/
-void TWI_write(uint8_t data)
+uint8_t TWI_write(uint8_t data)
 {
-	TWDR = data;
-	TWI_WRITE();
-	while (!(TWCR & (1 << TWINT)));
+	if (_twi.length >= TWI_BUFFER_SIZE)
+	{
+		_twi.overflow = 1;
+		return 0;
+	}
+	_twi.txBuffer[_twi.length++] = data;
+	return 1;
 }
 
 /*********************************************
 Function: requesrFrom()
-Purpose:  Request data from slave
-Input:    Address of the slave and amount of bytes supposed to get
-Return:   None
+Purpose:  Request data from slave, bytes written since beginTransmission() are sent first
+Input:    Address of the slave and amount of bytes supposed to get (up to TWI_BUFFER_SIZE)
+Return:   Status of the transaction, TWI_ERROR_OVERFLOW if the writes or the bytes do not fit the buffers
 *********************************************/
-void TWI_requestFrom(uint8_t address, uint8_t bytes)
+uint8_t TWI_requestFrom(uint8_t address, uint8_t bytes)
 {
-	_bytes = bytes;
-	TWI_START();
-	while (!(TWCR & (1 << TWINT)));
-	address = ((address << 1) | 1);
-	TWDR = address;
-	TWI_WRITE();
-	while (!(TWCR & (1 << TWINT)));
+	uint8_t status;
+	uint8_t write = (_twi.pending && _twi.address == address);
+	_twi.pending = 0;
+	_twi.rxIndex  = 0;
+	_twi.rxLength = 0;
+	if ((write && _twi.overflow) || bytes > TWI_BUFFER_SIZE)
+		return TWI_ERROR_OVERFLOW;
+	_twi.transaction.address     = address;
+	_twi.transaction.writeBuffer = _twi.txBuffer;
+	_twi.transaction.writeLength = write ? _twi.length : 0;
+	_twi.transaction.readBuffer  = _twi.rxBuffer;
+	_twi.transaction.readLength  = bytes;
+	_twi.transaction.callback    = 0;
+	status = TWI_transfer(&_twi.transaction);
+	_twi.rxLength = (status == TWI_OK) ? _twi.transaction.readLength : 0;
+	return status;
 }
 
 /*********************************************
@@ -116,38 +493,445 @@ Return:   Data from slave
 *********************************************/
 uint8_t TWI_read()
 {
-	(--_bytes > 0) ? TWI_READ(1) : ((_bytes == 0) ? TWI_READ(0) : 0);
-	while (!(TWCR & (1 << TWINT)));
-	return TWDR;
+	return (_twi.rxIndex < _twi.rxLength) ? _twi.rxBuffer[_twi.rxIndex++] : 0;
 }
 
 /*********************************************
 Function: endTransmission()
 Purpose:  End transmission of data
 Input:    None
+Return:   Status of the transaction
+*********************************************/
+uint8_t TWI_endTransmission()
+{
+	if (!_twi.pending)
+		return TWI_OK;
+	_twi.pending = 0;
+	if (_twi.overflow)
+		return TWI_ERROR_OVERFLOW;
+	_twi.transaction.address     = _twi.address;
+	_twi.transaction.writeBuffer = _twi.txBuffer;
+	_twi.transaction.writeLength = _twi.length;
+	_twi.transaction.readBuffer  = 0;
+	_twi.transaction.readLength  = 0;
+	_twi.transaction.callback    = 0;
+	return TWI_transfer(&_twi.transaction);
+}
+
+/*********************************************
+Function: readRegisters()
+Purpose:  Read consecutive registers in one transaction (register pointer write, repeated START, burst read)
+Input:    Address of the slave, first register, buffer for the data and amount of registers
+Return:   Status of the transaction
+*********************************************/
+uint8_t TWI_readRegisters(uint8_t address, uint8_t reg, uint8_t* data, uint8_t size)
+{
+	_twi.pending = 0;
+	_twi.txBuffer[0] = reg;
+	_twi.transaction.address     = address;
+	_twi.transaction.writeBuffer = _twi.txBuffer;
+	_twi.transaction.writeLength = 1;
+	_twi.transaction.readBuffer  = data;
+	_twi.transaction.readLength  = size;
+	_twi.transaction.callback    = 0;
+	return TWI_transfer(&_twi.transaction);
+}
+
+/*********************************************
+Function: writeRegisters()
+Purpose:  Write consecutive registers in one transaction
+Input:    Address of the slave, first register, data and amount of registers (up to TWI_BUFFER_SIZE - 1)
+Return:   Status of the transaction, TWI_ERROR_OVERFLOW if the registers do not fit the buffer (nothing is sent)
+*********************************************/
+uint8_t TWI_writeRegisters(uint8_t address, uint8_t reg, const uint8_t* data, uint8_t size)
+{
+	uint8_t i;
+	_twi.pending = 0;
+	if (size > TWI_BUFFER_SIZE - 1)
+		return TWI_ERROR_OVERFLOW;
+	_twi.txBuffer[0] = reg;
+	for (i = 0; i < size; i++)
+		_twi.txBuffer[i + 1] = data[i];
+	_twi.transaction.address     = address;
+	_twi.transaction.writeBuffer = _twi.txBuffer;
+	_twi.transaction.writeLength = size + 1;
+	_twi.transaction.readBuffer  = 0;
+	_twi.transaction.readLength  = 0;
+	_twi.transaction.callback    = 0;
+	return TWI_transfer(&_twi.transaction);
+}
+
+/*********************************************
+Function: beginSlave()
+Purpose:  Answer as slave with a double buffered register map
+Input:    Own address, 1 to answer the general call, register map of 2 * size bytes (front and back snapshot),
+          amount of registers and function called when a master writes a register (optional)
+Return:   None
+*********************************************/
+void TWI_beginSlave(uint8_t address, uint8_t generalCall, uint8_t* registers, uint8_t size, void (*callback)(uint8_t reg, uint8_t data))
+{
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		_twiSlave.registers[0] = registers;
+		_twiSlave.registers[1] = registers + size;
+		_twiSlave.size     = size;
+		_twiSlave.pointer  = 0;
+		_twiSlave.front    = 0;
+		_twiSlave.pending  = 0;
+		_twiSlave.synced   = 0;
+		_twiSlave.active   = 0;
+		_twiSlave.callback = callback;
+		_twi.acknowledge   = (1 << TWEA);
+		TWAR = (address << 1) | (generalCall ? (1 << TWGCE) : 0);
+		if (!_twi.busy)
+			TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWEA);
+	}
+	// Enable global interrupts
+	sei();
+}
+
+/*********************************************
+Function: slaveRegisters()
+Purpose:  Get the back snapshot of the register map for updating
+Input:    None
+Return:   Back snapshot holding the published values or 0 while the last commit is not applied yet
+*********************************************/
+uint8_t* TWI_slaveRegisters(void)
+{
+	uint8_t i;
+	uint8_t* back = 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (!_twiSlave.pending)
+		{
+			back = _twiSlave.registers[_twiSlave.front ^ 1];
+			if (!_twiSlave.synced)                        // Start from the values the master sees
+			{
+				for (i = 0; i < _twiSlave.size; i++)
+					back[i] = _twiSlave.registers[_twiSlave.front][i];
+				_twiSlave.synced = 1;
+			}
+		}
+	}
+	return back;
+}
+
+/*********************************************
+Function: slaveCommit()
+Purpose:  Publish the back snapshot to the master
+Input:    None
+Return:   None
+*********************************************/
+void TWI_slaveCommit(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (_twiSlave.active)
+			_twiSlave.pending = 1;                        // Swapped when the slave transfer ends
+		else
+		{
+			_twiSlave.front ^= 1;
+			_twiSlave.synced = 0;
+		}
+	}
+}
+
+/*********************************************
+Function: configure()
+Purpose:  Apply bit rate and prescaler, reset the engine and enable TWI
+Input:    TWBR value and TWPS bits
+Return:   Achieved SCL frequency in Hz
+*********************************************/
+static uint32_t TWI_configure(uint8_t bitRate, uint8_t prescaler)
+{
+	TWI_DDR  &= ~((1 << TWI_SDA) | (1 << TWI_SCL));
+	TWI_PORT &= ~((1 << TWI_SDA) | (1 << TWI_SCL));
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		_twi.head    = 0;
+		_twi.tail    = 0;
+		_twi.busy    = 0;
+		_twi.waiting = 0;
+	}
+	TWBR = bitRate;
+	TWSR = prescaler;
+	_twi.frequency = F_CPU / (16UL + 2UL * bitRate * (1UL << (2 * prescaler))); // Achieved SCL frequency
+	_twi.timeout   = (9000000UL / _twi.frequency + 1) * TWI_TIMEOUT_BYTES;       // Microseconds without bus activity
+	if (!(TWI_PIN & (1 << TWI_SDA)))                                              // SDA held low by a slave
+		TWI_busClear();
+	TWCR = (1 << TWEN) | (1 << TWIE) | _twi.acknowledge;
+	// Enable global interrupts
+	sei();
+	return _twi.frequency;
+}
+
+/*********************************************
+Function: handleInterrupt()
+Purpose:  Move the current transaction one bus event forward
+Input:    None
+Return:   None
+*********************************************/
+static void TWI_handleInterrupt(void)
+{
+	TWI_transaction* transaction = _twi.queue[(_twi.tail + 1) & TWI_QUEUE_MASK];
+	uint8_t status = TW_STATUS;
+	_twi.events++;
+	if (status >= TW_SR_SLA_ACK && status <= TW_ST_LAST_DATA)
+	{
+		TWI_handleSlave(status);
+		return;
+	}
+	_twi.waiting = 0;
+	if (!_twi.busy || !transaction)                              // Bus error or stray event with no transaction
+	{
+		_twi.statistics.bus++;
+		TWI_STOP();                                               // TWSTO & TWINT clear a bus error, no STOP is sent
+		return;
+	}
+	switch (status)
+	{
+		case TW_START:                                            // START sent, pick the first phase
+			_twi.reading = (!transaction->writeLength && transaction->readLength);
+			// Fall through
+		case TW_REP_START:                                        // Repeated START sent
+			_twi.index = 0;
+			transaction->clocks += 1;
+			TWDR = (transaction->address << 1) | (_twi.reading ? TW_READ : TW_WRITE);
+			TWI_WRITE();
+			break;
+		case TW_MT_SLA_ACK:                                       // SLA+W acknowledged
+		case TW_MT_DATA_ACK:                                      // Data byte acknowledged
+			transaction->clocks += 9;
+			if (_twi.index < transaction->writeLength)
+			{
+				TWDR = transaction->writeBuffer[_twi.index++];
+				TWI_WRITE();
+			}
+			else if (transaction->readLength)
+			{
+				_twi.reading = 1;
+				TWI_START();                                      // Repeated START for the read phase
+			}
+			else
+				TWI_complete(TWI_OK, 1);
+			break;
+		case TW_MR_SLA_ACK:                                       // SLA+R acknowledged
+			transaction->clocks += 9;
+			TWI_READ(transaction->readLength > 1);
+			break;
+		case TW_MR_DATA_ACK:                                      // Data byte received, ACK returned
+			transaction->clocks += 9;
+			transaction->readBuffer[_twi.index++] = TWDR;
+			TWI_READ(_twi.index < (uint8_t)(transaction->readLength - 1));
+			break;
+		case TW_MR_DATA_NACK:                                     // Last data byte received, NACK returned
+			transaction->clocks += 9;
+			transaction->readBuffer[_twi.index++] = TWDR;
+			TWI_complete(TWI_OK, 1);
+			break;
+		case TW_MT_SLA_NACK:                                      // SLA+W not acknowledged
+		case TW_MT_DATA_NACK:                                     // Data byte not acknowledged
+		case TW_MR_SLA_NACK:                                      // SLA+R not acknowledged
+			transaction->clocks += 9;
+			TWI_complete(TWI_ERROR_NACK, 1);
+			break;
+		case TW_MT_ARB_LOST:                                      // Arbitration lost, bus released by hardware
+			_twi.statistics.arbitration++;
+			if (transaction->retries < TWI_ARBITRATION_RETRIES)
+			{
+				transaction->retries++;
+				_twi.statistics.retry++;
+				_twi.waiting = 1;
+				TWI_START();                                      // Held back by hardware until the bus is free
+			}
+			else
+				TWI_complete(TWI_ERROR_ARBITRATION, 0);
+			break;
+		default:                                                  // Bus error or unexpected status
+			TWI_complete(TWI_ERROR_BUS, 1);
+			break;
+	}
+}
+
+/*********************************************
+Function: complete()
+Purpose:  Finish the current transaction and start the next queued one
+Input:    Status of the transaction, 1 if a STOP has to be sent
+Return:   None
+*********************************************/
+static void TWI_complete(uint8_t status, uint8_t stop)
+{
+	_twi.tail = (_twi.tail + 1) & TWI_QUEUE_MASK;
+	TWI_transaction* transaction = _twi.queue[_twi.tail];
+	transaction->clocks += stop;
+	transaction->status  = status;
+	_twi.statistics.transactions++;
+	_twi.statistics.clocks += transaction->clocks;
+	switch (status)
+	{
+		case TWI_ERROR_NACK:    _twi.statistics.nack++;    break;
+		case TWI_ERROR_BUS:     _twi.statistics.bus++;     break;
+		case TWI_ERROR_TIMEOUT: _twi.statistics.timeout++; break;
+	}
+	if (transaction->callback)
+		transaction->callback(transaction);             // May queue the next transaction
+	if (_twi.head != _twi.tail)
+		stop ? TWI_RESTART() : TWI_START();             // STOP followed by START of the next transaction
+	else
+	{
+		_twi.busy = 0;
+		stop ? TWI_STOP() : TWI_RELEASE();
+	}
+}
+
+/*********************************************
+Function: handleSlave()
+Purpose:  Move the slave transfer one bus event forward
+Input:    Status of the bus event
+Return:   None
+*********************************************/
+static void TWI_handleSlave(uint8_t status)
+{
+	uint8_t data;
+	switch (status)
+	{
+		case TW_SR_ARB_LOST_SLA_ACK:                              // Lost arbitration as master and addressed as slave
+		case TW_SR_ARB_LOST_GCALL_ACK:                            // (master transaction restarts when the transfer ends)
+			_twi.statistics.arbitration++;
+			_twi.statistics.retry++;
+			// Fall through
+		case TW_SR_SLA_ACK:                                       // Own SLA+W received
+		case TW_SR_GCALL_ACK:                                     // General call received
+			_twiSlave.active = 1;
+			_twiSlave.first  = 1;
+			TWI_RELEASE();
+			break;
+		case TW_ST_ARB_LOST_SLA_ACK:                              // Lost arbitration as master and addressed as slave
+			_twi.statistics.arbitration++;
+			_twi.statistics.retry++;
+			// Fall through
+		case TW_ST_SLA_ACK:                                       // Own SLA+R received
+			_twiSlave.active = 1;
+			// Fall through
+		case TW_ST_DATA_ACK:                                      // Data byte sent, ACK received
+			TWDR = _twiSlave.registers[_twiSlave.front][_twiSlave.pointer];
+			if (++_twiSlave.pointer >= _twiSlave.size)
+				_twiSlave.pointer = 0;
+			TWI_RELEASE();
+			break;
+		case TW_SR_DATA_ACK:                                      // Data byte received, ACK returned
+		case TW_SR_GCALL_DATA_ACK:
+			data = TWDR;
+			if (_twiSlave.first)                                  // First byte is the register pointer
+			{
+				_twiSlave.first   = 0;
+				_twiSlave.pointer = (data < _twiSlave.size) ? data : 0;
+			}
+			else
+			{
+				_twiSlave.registers[0][_twiSlave.pointer] = data; // Keep both snapshots in sync
+				_twiSlave.registers[1][_twiSlave.pointer] = data;
+				if (_twiSlave.callback)
+					_twiSlave.callback(_twiSlave.pointer, data);
+				if (++_twiSlave.pointer >= _twiSlave.size)
+					_twiSlave.pointer = 0;
+			}
+			TWI_RELEASE();
+			break;
+		default:                                                  // STOP, repeated START or last byte sent
+			TWI_slaveEnd();
+			break;
+	}
+}
+
+/*********************************************
+Function: slaveEnd()
+Purpose:  Apply a pending commit and give the bus back to queued master transactions
+Input:    None
+Return:   None
+*********************************************/
+static void TWI_slaveEnd(void)
+{
+	_twiSlave.active = 0;
+	if (_twiSlave.pending)
+	{
+		_twiSlave.front ^= 1;
+		_twiSlave.synced  = 0;
+		_twiSlave.pending = 0;
+	}
+	if (_twi.busy)
+	{
+		_twi.waiting = 1;
+		TWI_START();                                              // Sent as soon as the bus is free
+	}
+	else
+		TWI_RELEASE();
+}
+
+/*********************************************
+Function: wait()
+Purpose:  Queue a transaction and wait for it to complete, recovering the bus on timeout
+Input:    Transaction descriptor, microseconds without bus activity before giving up
+Return:   Status of the transaction
+*********************************************/
+static uint8_t TWI_wait(TWI_transaction* transaction, uint32_t timeout)
+{
+	uint8_t  events = _twi.events;
+	uint32_t idle   = 0;
+	while (!TWI_submit(transaction))
+		TWI_watchdog(&events, &idle, timeout);
+	while (transaction->status == TWI_PENDING)
+		TWI_watchdog(&events, &idle, timeout);
+	return transaction->status;
+}
+
+/*********************************************
+Function: watchdog()
+Purpose:  Recover the bus when a blocking call sees no bus activity for too long
+Input:    Last seen event count and idle time of the caller, timeout in microseconds
 Return:   None
 *********************************************/
-void TWI_endTransmission()
+static void TWI_watchdog(uint8_t* events, uint32_t* idle, uint32_t timeout)
 {
-	TWI_STOP();
-	while(TWCR & (1<<TWSTO));
+	if (*events != _twi.events || _twi.waiting)     // Activity, or another master owns the bus
+	{
+		*events = _twi.events;
+		*idle   = 0;
+	}
+	else if (++(*idle) > timeout)
+	{
+		*idle = 0;
+		TWI_recover();
+	}
+	_delay_us(1);
 }
 
 /*********************************************
-Function: handleSpeed()
-Purpose:  Handle TWI speed selection
-Input:    Speed of TWI
-Return:   Return 1 if successful and 0 if not
+Function: busClear()
+Purpose:  Clock SCL until a stuck slave releases SDA and send a STOP
+Input:    None
+Return:   None
 *********************************************/
-static uint8_t handleSpeed(uint8_t speed)
+static void TWI_busClear(void)
 {
-	switch (speed)
+	uint8_t i;
+	TWCR = 0;                                        // Give the pins back to the port
+	TWI_DDR  &= ~((1 << TWI_SDA) | (1 << TWI_SCL));  // Release both lines
+	TWI_PORT &= ~((1 << TWI_SDA) | (1 << TWI_SCL));  // Lines are pulled low by switching to output
+	if (TWI_PIN & (1 << TWI_SDA))                    // SDA free, nothing to clear
+		return;
+	_twi.statistics.recovery++;
+	for (i = 0; i < 9 && !(TWI_PIN & (1 << TWI_SDA)); i++)
 	{
-		case F_TWI_100K: TWBR = F_TWI_100K; return 1;
-		case F_TWI_250K: TWBR = F_TWI_250K; return 1;
-		case F_TWI_400K: TWBR = F_TWI_400K; return 1;
-		default: return 0;
+		TWI_DDR |= (1 << TWI_SCL);                   // SCL low
+		_delay_us(5);
+		TWI_DDR &= ~(1 << TWI_SCL);                  // SCL high
+		_delay_us(5);
 	}
+	TWI_DDR |= (1 << TWI_SDA);                       // SDA low while SCL is high
+	_delay_us(5);
+	TWI_DDR &= ~(1 << TWI_SDA);                      // SDA high while SCL is high (STOP)
+	_delay_us(5);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -71,24 +71,255 @@ CS02/CS01/CS00 - Clock Source
 |  1   |  0   |  1   |     Clock/1024     |
 |  1   |  1   |  0   | Clock/T0 (Falling) |
 |  1   |  1   |  1   | Clock/T0 (Rising)  |
+
+//
+// TIMER 1 TICK
+//
+
+The tick period is set at compile time with TIMER1_TICK_US (default 1000 us), e.g. -DTIMER1_TICK_US=250
+The smallest prescaler whose OCR1A fits in 16 bit is selected (best resolution), OCR1A is rounded to the nearest count
+| PRESCALER | 16 MHz max period | 12.288 MHz max period |
+|     1     |      4.096 ms     |        5.333 ms       |
+|     8     |     32.768 ms     |       42.667 ms       |
+|    64     |    262.144 ms     |      341.333 ms       |
+|    256    |   1048.576 ms     |     1365.333 ms       |
+|    1024   |   4194.304 ms     |     5461.333 ms       |
+A period longer than the last column or shorter than TIMER1_MIN_CYCLES CPU cycles is a compile error
+TIMER1_ERROR_PPM is the error of the real tick against the requested one, e.g. 16 MHz, 1000 us: OCR1A 15999, 0 ppm
+	define TIMER1_MAX_ERROR_PPM to turn a larger error into a compile error
+millis() counts whole milliseconds, for periods that are not a multiple of 1 ms the ISR carries the remainder
+Timer1 runs in Fast PWM with OCR1A as TOP (WGM13:0 = 15), it counts and interrupts exactly like CTC
+	but leaves OC1B free for PWM at the tick frequency and ICP1 free for input capture
+
+//
+// PWM
+//
+
+| OUTPUT | ATmega16 pin | Timer  | Frequency                                                        |
+|  OC0   |     PB3      | Timer0 | Fast: F_CPU / (PRESCALER * 256), Phase correct: F_CPU / (PRESCALER * 510) |
+|  OC2   |     PD7      | Timer2 | Same as Timer0, prescalers 1, 8, 32, 64, 128, 256, 1024          |
+|  OC1B  |     PD4      | Timer1 | Tick frequency (1 / TIMER1_TICK_US), fast only, TIMER1_TOP + 1 steps |
+OC1A cannot be used for PWM, OCR1A is the TOP of the tick
+Duty = active time, the active level is high or low with TIMER_INVERTED
+	8 bit timers: 0 = always inactive, 255 = always active
+	OC1B:         0 = always inactive, TIMER1_TOP = always active
+OCR0, OCR2 & OCR1B are double buffered in PWM modes, a new duty takes effect at TOP so no period is ever cut or doubled
+Fast PWM cannot reach 0 % (OCR = 0 still gives a one count pulse), a duty of 0 disconnects the pin
+	and PORT drives it to the inactive level, any other duty connects it again
+Phase correct PWM reaches 0 % & 100 % with OCR alone, the pin stays connected
+
+//
+// INPUT CAPTURE (define TIMER1_CAPTURE)
+//
+
+ICP1 (PD6 on ATmega16) edges copy TCNT1 into ICR1 in hardware, the ISR turns it into a 32 bit timestamp
+	timestamp = ticks * (TIMER1_TOP + 1) + ICR1, in Timer1 counts (PRESCALER / F_CPU, 0.5 us at 16 MHz & 1 ms tick)
+Timestamps & edges are stored in a ring of TIMER1_CAPTURE_BUFFER entries, the main loop reads them at its pace
+	pulse width = (later.time - earlier.time), TIMER1_toMicros() converts it
+TIMER1_CAPTURE_BOTH swaps the edge after every capture, so high & low times of e.g. an RFID data line are measured
+	an edge that comes within a few cycles of the previous one (before the ISR swaps the edge) is lost
+TIMER1_CAPTURE_FILTER enables the noise canceler: the level must be stable for 4 samples, the capture is 4 cycles late
+
+//
+// MICROS
+//
+
+micros() = ticks * tick period + TCNT1 converted to us
+OCF1A is set (and the ISR counts the tick) at the timer clock after the compare match, when TCNT1 goes from TOP to 0
+	- TCNT1 below TOP / 2 with OCF1A pending: restarted before the ISR ran, the pending tick is counted
+	- Any other count: the tick of this period is still to come, _timer1Counter is right
+	- The tick ISR must never be held off for half a tick or more
+	TIMER1_CAPT_vect turns ICR1 into ticks the same way
+Resolution = PRESCALER / F_CPU, but never better than 1 us
+| PRESCALER | 16 MHz  | 12.288 MHz | 8 MHz |
+|     1     |  1 us   |    1 us    | 1 us  |
+|     8     |  1 us   |    1 us    | 1 us  |
+|    64     |  4 us   |  5.2 us    | 8 us  |
+|    256    |  16 us  |  20.8 us   | 32 us |
+|    1024   |  64 us  |  83.3 us   | 128 us|
+micros() wraps after 2^32 us = 71.6 minutes, compare with (now - start) like millis()
+When F_CPU / PRESCALER is a multiple of 1 MHz the conversion is a division by a constant (a shift for 16 MHz),
+	otherwise us per count = PRESCALER * 1000 / (F_CPU / 1000) is split into a whole part and a remainder,
+	count * remainder < 65536 * F_CPU / 1000 always fits 32 bits (a single product overflows with large prescalers)
 */
 
+#ifndef TIMER1_TICK_US
+	#define TIMER1_TICK_US 1000UL // Tick period in us
+#endif
+#define TIMER1_MIN_CYCLES 200         // The compare ISR must be able to keep up
+
+#define TIMER1_COUNTS(us, prescaler) ((1ULL * (F_CPU) * (us) + (prescaler) * 500000ULL) / ((prescaler) * 1000000ULL)) // Rounded
+#define TIMER1_FITS(us, prescaler)   (TIMER1_COUNTS(us, prescaler) >= 1 && TIMER1_COUNTS(us, prescaler) <= 65536)
+#define TIMER1_PRESCALER             (TIMER1_FITS(TIMER1_TICK_US, 1)   ? 1   : \
+                                      TIMER1_FITS(TIMER1_TICK_US, 8)   ? 8   : \
+                                      TIMER1_FITS(TIMER1_TICK_US, 64)  ? 64  : \
+                                      TIMER1_FITS(TIMER1_TICK_US, 256) ? 256 : 1024)
+#define TIMER1_CLOCK_SELECT          ((TIMER1_PRESCALER == 1)  ? (1 << CS10) : \
+                                      (TIMER1_PRESCALER == 8)  ? (1 << CS11) : \
+                                      (TIMER1_PRESCALER == 64) ? ((1 << CS11) | (1 << CS10)) : \
+                                      (TIMER1_PRESCALER == 256) ? (1 << CS12) : ((1 << CS12) | (1 << CS10)))
+#define TIMER1_TOP                   (TIMER1_COUNTS(TIMER1_TICK_US, TIMER1_PRESCALER) - 1)                   // OCR1A
+#define TIMER1_US_DIVISOR            ((uint32_t)((F_CPU) / 1000UL))                                           // us per count =
+#define TIMER1_US_QUOTIENT           ((uint32_t)(TIMER1_PRESCALER * 1000UL / TIMER1_US_DIVISOR))              // QUOTIENT +
+#define TIMER1_US_REMAINDER          ((uint32_t)(TIMER1_PRESCALER * 1000UL % TIMER1_US_DIVISOR))              // REMAINDER / DIVISOR
+#define TIMER1_ERROR_PPM             ((1LL * (TIMER1_TOP + 1) * TIMER1_PRESCALER * 1000000LL - 1LL * (F_CPU) * TIMER1_TICK_US) \
+                                      * 1000000LL / (1LL * (F_CPU) * TIMER1_TICK_US))
+
+#if (1ULL * (F_CPU) * TIMER1_TICK_US / 1000000ULL) < TIMER1_MIN_CYCLES
+	#error "Timer1 tick period is too short for this F_CPU"
+#endif
+#if !TIMER1_FITS(TIMER1_TICK_US, 1024)
+	#error "Timer1 tick period cannot be reached with this F_CPU"
+#endif
+#if defined(TIMER1_MAX_ERROR_PPM) && ((TIMER1_ERROR_PPM > TIMER1_MAX_ERROR_PPM) || (-TIMER1_ERROR_PPM > TIMER1_MAX_ERROR_PPM))
+	#error "Timer1 tick error is above TIMER1_MAX_ERROR_PPM"
+#endif
+
+// PWM modes
+// ******************************************************************************************************************
+#define TIMER_FAST_PWM  0x00
+#define TIMER_PHASE_PWM 0x01 // Timer0 & Timer2 only
+#define TIMER_INVERTED  0x02 // Active low, OR with the mode
+
+// Timer0 clock select
+// ******************************************************************************************************************
+#define TIMER0_CLOCK_1    (1 << CS00)
+#define TIMER0_CLOCK_8    (1 << CS01)
+#define TIMER0_CLOCK_64   ((1 << CS01) | (1 << CS00))
+#define TIMER0_CLOCK_256  (1 << CS02)
+#define TIMER0_CLOCK_1024 ((1 << CS02) | (1 << CS00))
+
+// Timer2 clock select
+// ******************************************************************************************************************
+#define TIMER2_CLOCK_1    (1 << CS20)
+#define TIMER2_CLOCK_8    (1 << CS21)
+#define TIMER2_CLOCK_32   ((1 << CS21) | (1 << CS20))
+#define TIMER2_CLOCK_64   (1 << CS22)
+#define TIMER2_CLOCK_128  ((1 << CS22) | (1 << CS20))
+#define TIMER2_CLOCK_256  ((1 << CS22) | (1 << CS21))
+#define TIMER2_CLOCK_1024 ((1 << CS22) | (1 << CS21) | (1 << CS20))
+
+// ATmega16 / 32 pins
+// ******************************************************************************************************************
+#define TIMER0_OC_DDR   DDRB
+#define TIMER0_OC_PORT  PORTB
+#define TIMER0_OC_PIN   PB3
+#define TIMER2_OC_DDR   DDRD
+#define TIMER2_OC_PORT  PORTD
+#define TIMER2_OC_PIN   PD7
+#define TIMER1_OCB_DDR  DDRD
+#define TIMER1_OCB_PORT PORTD
+#define TIMER1_OCB_PIN  PD4
+#define TIMER1_ICP_DDR  DDRD
+#define TIMER1_ICP_PIN  PIND
+#define TIMER1_ICP_BIT  PD6
+
+// Input capture
+// ******************************************************************************************************************
+#define TIMER1_CAPTURE_FALLING 0x00
+#define TIMER1_CAPTURE_RISING  0x01
+#define TIMER1_CAPTURE_BOTH    0x02 // Starts with the edge that leaves the current level
+#define TIMER1_CAPTURE_FILTER  0x04 // Noise canceler, OR with the edge
+
+#ifndef TIMER1_CAPTURE_BUFFER
+	#define TIMER1_CAPTURE_BUFFER 16 // Power of 2, one slot stays free
+#endif
+#define TIMER1_CAPTURE_MASK (TIMER1_CAPTURE_BUFFER - 1)
+
+#if (TIMER1_CAPTURE_BUFFER & TIMER1_CAPTURE_MASK) || (TIMER1_CAPTURE_BUFFER > 256)
+	#error "TIMER1_CAPTURE_BUFFER must be a power of 2 up to 256"
+#endif
+
+typedef struct
+{
+	unsigned long time;   // Timer1 counts, wraps like micros()
+	uint8_t       rising; // 1 for a rising edge, 0 for a falling one
+}TIMER1_edge;
+
 volatile unsigned long _timer1Counter;
+#if (TIMER1_TICK_US % 1000)
+volatile unsigned long _timer1Millis;
+uint16_t               _timer1Fraction; // us carried to the next millisecond
+#endif
 
 ISR (TIMER1_COMPA_vect)
 {
 	_timer1Counter++;
+	#if (TIMER1_TICK_US % 1000)
+	_timer1Millis   += TIMER1_TICK_US / 1000;
+	_timer1Fraction += TIMER1_TICK_US % 1000;
+	if (_timer1Fraction >= 1000)
+	{
+		_timer1Fraction -= 1000;
+		_timer1Millis++;
+	}
+	#endif
+}
+
+/*********************************************
+Function: TIMER1_ticks()
+Purpose:  Ticks at a Timer1 count, with interrupts disabled
+Input:    TCNT1 or ICR1 read just before
+Return:   Ticks
+*********************************************/
+static inline unsigned long TIMER1_ticks(uint16_t count)
+{
+	unsigned long ticks   = _timer1Counter;
+	uint8_t       pending = TIFR & (1 << OCF1A);
+
+	if (pending && count < (uint16_t)(TIMER1_TOP / 2))   // Restarted before the ISR ran
+		return ticks + 1;
+	return ticks;
 }
 
-void TIMER1_begin(uint8_t milliseconds)
+#if defined(TIMER1_CAPTURE)
+static struct
 {
-	// Clear Timer on Compare && Prescaler F_CPU / 1024
-	TCCR1B |= (1 << WGM12) | (1 << CS10);
+	TIMER1_edge      buffer[TIMER1_CAPTURE_BUFFER];
+	volatile uint8_t head, tail;
+	uint8_t          both;    // Swap the edge after every capture
+	volatile uint16_t dropped; // Edges lost because the buffer was full
+}_timer1Capture;
+
+ISR (TIMER1_CAPT_vect)
+{
+	uint16_t      count = ICR1;
+	unsigned long ticks = TIMER1_ticks(count); // The tick ISR has lower priority, its match may be pending
+	uint8_t       edge  = TCCR1B & (1 << ICES1);
+	uint8_t       tempHead;
+
+	if (_timer1Capture.both)
+	{
+		TCCR1B ^= (1 << ICES1);
+		TIFR    = (1 << ICF1); // Changing the edge may set ICF1
+	}
+	tempHead = (_timer1Capture.head + 1) & TIMER1_CAPTURE_MASK;
+	if (tempHead == _timer1Capture.tail)
+	{
+		_timer1Capture.dropped++;
+		return;
+	}
+	_timer1Capture.buffer[tempHead].time   = ticks * (unsigned long)(TIMER1_TOP + 1) + count;
+	_timer1Capture.buffer[tempHead].rising = edge ? 1 : 0;
+	_timer1Capture.head = tempHead;
+}
+#endif
+
+void TIMER1_begin(void)
+{
+	// Stopped & normal mode: OCR1A is double buffered in mode 15, with TOP still 0 the first tick would come at once
+	TCCR1B = 0;
+	TCCR1A = 0;
 	// Set the value of overflowing
-	OCR1A = (milliseconds / 1000.) / (1. / F_CPU);
-	//OCR1A = (F_CPU / 1000) / 1024;
-	// Enable the compare match interrupt
+	OCR1A = TIMER1_TOP;
+	TCNT1 = 0;
+	// Fast PWM with OCR1A as TOP (counts like CTC, OC1B usable)
+	TCCR1A = (1 << WGM11) | (1 << WGM10);
+	// Enable the compare match interrupt without a match left from before
+	TIFR   = (1 << OCF1A);
 	TIMSK |= (1 << OCIE1A);
+	// Start with the prescaler selected for TIMER1_TICK_US
+	TCCR1B = (1 << WGM13) | (1 << WGM12) | TIMER1_CLOCK_SELECT;
 }
 
 unsigned long millis()
@@ -96,9 +327,286 @@ unsigned long millis()
 	unsigned long millisValue;
 	ATOMIC_BLOCK(ATOMIC_FORCEON)
 	{
+		#if (TIMER1_TICK_US % 1000)
+		millisValue = _timer1Millis;
+		#else
 		millisValue = _timer1Counter;
+		#endif
 	}
+	#if (TIMER1_TICK_US % 1000)
 	return millisValue;
+	#else
+	return millisValue * (TIMER1_TICK_US / 1000);
+	#endif
+}
+
+unsigned long micros()
+{
+	unsigned long ticks;
+	uint16_t      count;
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		count = TCNT1;
+		ticks = TIMER1_ticks(count);
+	}
+	#if ((F_CPU / TIMER1_PRESCALER) % 1000000UL) == 0
+	return ticks * TIMER1_TICK_US + count / (uint16_t)((F_CPU / TIMER1_PRESCALER) / 1000000UL);
+	#else
+	return ticks * TIMER1_TICK_US + count * TIMER1_US_QUOTIENT + count * TIMER1_US_REMAINDER / TIMER1_US_DIVISOR;
+	#endif
+}
+
+/*********************************************
+Function: TIMER1_toMicros()
+Purpose:  Convert Timer1 counts (e.g. a pulse width) to us
+Input:    Counts
+Return:   us
+*********************************************/
+unsigned long TIMER1_toMicros(unsigned long counts)
+{
+	#if ((F_CPU / TIMER1_PRESCALER) % 1000000UL) == 0
+	return counts / ((F_CPU / TIMER1_PRESCALER) / 1000000UL);
+	#else
+	uint32_t value = counts;
+	// counts = whole * DIVISOR + rest, rest * REMAINDER fits 32 bits like in micros()
+	return value * TIMER1_US_QUOTIENT + (value / TIMER1_US_DIVISOR) * TIMER1_US_REMAINDER
+	     + (value % TIMER1_US_DIVISOR) * TIMER1_US_REMAINDER / TIMER1_US_DIVISOR;
+	#endif
+}
+
+static uint8_t _timer0Output; // COM bits of the selected PWM output
+static uint8_t _timer2Output;
+static uint8_t _timer1OutputB;
+
+/*********************************************
+Function: TIMER0_pwm()
+Purpose:  Start PWM on OC0, the duty starts at 0
+Input:    TIMER_FAST_PWM or TIMER_PHASE_PWM (| TIMER_INVERTED), TIMER0_CLOCK_x
+Return:   None
+*********************************************/
+void TIMER0_pwm(uint8_t mode, uint8_t clock)
+{
+	_timer0Output = (mode & TIMER_INVERTED) ? ((1 << COM01) | (1 << COM00)) : (1 << COM01);
+	// Inactive level while disconnected
+	if (mode & TIMER_INVERTED)
+		TIMER0_OC_PORT |= (1 << TIMER0_OC_PIN);
+	else
+		TIMER0_OC_PORT &= ~(1 << TIMER0_OC_PIN);
+	TIMER0_OC_DDR |= (1 << TIMER0_OC_PIN);
+	OCR0  = 0;
+	TCNT0 = 0;
+	if (mode & TIMER_PHASE_PWM)
+		TCCR0 = (1 << WGM00) | _timer0Output | clock;
+	else
+		TCCR0 = (1 << WGM00) | (1 << WGM01) | clock;
+}
+
+/*********************************************
+Function: TIMER0_duty()
+Purpose:  Set the OC0 duty, takes effect at the next TOP
+Input:    0 (inactive) - 255 (active)
+Return:   None
+*********************************************/
+void TIMER0_duty(uint8_t duty)
+{
+	OCR0 = duty;
+	if (TCCR0 & (1 << WGM01))
+	{
+		// Fast PWM: 0 % only with the pin disconnected
+		if (duty)
+			TCCR0 |= _timer0Output;
+		else
+			TCCR0 &= ~((1 << COM01) | (1 << COM00));
+	}
+}
+
+/*********************************************
+Function: TIMER0_stop()
+Purpose:  Stop Timer0, OC0 goes to its inactive level
+Input:    None
+Return:   None
+*********************************************/
+void TIMER0_stop(void)
+{
+	TCCR0 = 0;
+}
+
+/*********************************************
+Function: TIMER2_pwm()
+Purpose:  Start PWM on OC2, the duty starts at 0
+Input:    TIMER_FAST_PWM or TIMER_PHASE_PWM (| TIMER_INVERTED), TIMER2_CLOCK_x
+Return:   None
+*********************************************/
+void TIMER2_pwm(uint8_t mode, uint8_t clock)
+{
+	_timer2Output = (mode & TIMER_INVERTED) ? ((1 << COM21) | (1 << COM20)) : (1 << COM21);
+	// Inactive level while disconnected
+	if (mode & TIMER_INVERTED)
+		TIMER2_OC_PORT |= (1 << TIMER2_OC_PIN);
+	else
+		TIMER2_OC_PORT &= ~(1 << TIMER2_OC_PIN);
+	TIMER2_OC_DDR |= (1 << TIMER2_OC_PIN);
+	OCR2  = 0;
+	TCNT2 = 0;
+	if (mode & TIMER_PHASE_PWM)
+		TCCR2 = (1 << WGM20) | _timer2Output | clock;
+	else
+		TCCR2 = (1 << WGM20) | (1 << WGM21) | clock;
+}
+
+/*********************************************
+Function: TIMER2_duty()
+Purpose:  Set the OC2 duty, takes effect at the next TOP
+Input:    0 (inactive) - 255 (active)
+Return:   None
+*********************************************/
+void TIMER2_duty(uint8_t duty)
+{
+	OCR2 = duty;
+	if (TCCR2 & (1 << WGM21))
+	{
+		// Fast PWM: 0 % only with the pin disconnected
+		if (duty)
+			TCCR2 |= _timer2Output;
+		else
+			TCCR2 &= ~((1 << COM21) | (1 << COM20));
+	}
+}
+
+/*********************************************
+Function: TIMER2_stop()
+Purpose:  Stop Timer2, OC2 goes to its inactive level
+Input:    None
+Return:   None
+*********************************************/
+void TIMER2_stop(void)
+{
+	TCCR2 = 0;
+}
+
+/*********************************************
+Function: TIMER1_dutyB()
+Purpose:  Set the OC1B duty, takes effect at the next tick
+Input:    0 (inactive) - TIMER1_TOP (active), active for duty + 1 counts of TIMER1_TOP + 1
+Return:   None
+*********************************************/
+void TIMER1_dutyB(uint16_t duty)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		OCR1B = duty; // 16 bit write through the TEMP register
+	}
+	if (duty)
+		TCCR1A |= _timer1OutputB;
+	else
+		TCCR1A &= ~((1 << COM1B1) | (1 << COM1B0));
+}
+
+/*********************************************
+Function: TIMER1_pwmB()
+Purpose:  Start PWM on OC1B at the tick frequency, call after TIMER1_begin(), the duty starts at 0
+Input:    TIMER_FAST_PWM or TIMER_FAST_PWM | TIMER_INVERTED
+Return:   None
+*********************************************/
+void TIMER1_pwmB(uint8_t mode)
+{
+	_timer1OutputB = (mode & TIMER_INVERTED) ? ((1 << COM1B1) | (1 << COM1B0)) : (1 << COM1B1);
+	// Inactive level while disconnected
+	if (mode & TIMER_INVERTED)
+		TIMER1_OCB_PORT |= (1 << TIMER1_OCB_PIN);
+	else
+		TIMER1_OCB_PORT &= ~(1 << TIMER1_OCB_PIN);
+	TIMER1_OCB_DDR |= (1 << TIMER1_OCB_PIN);
+	TIMER1_dutyB(0);
+}
+
+#if defined(TIMER1_CAPTURE)
+/*********************************************
+Function: TIMER1_capture()
+Purpose:  Start timestamping ICP1 edges, call after TIMER1_begin()
+Input:    TIMER1_CAPTURE_RISING, _FALLING or _BOTH (| TIMER1_CAPTURE_FILTER)
+Return:   None
+*********************************************/
+void TIMER1_capture(uint8_t edge)
+{
+	uint8_t control = TCCR1B & ~((1 << ICNC1) | (1 << ICES1));
+
+	TIMER1_ICP_DDR &= ~(1 << TIMER1_ICP_BIT);
+	if (edge & TIMER1_CAPTURE_FILTER)
+		control |= (1 << ICNC1);
+	if (edge & TIMER1_CAPTURE_BOTH)
+	{
+		// Wait for the edge that leaves the current level
+		if (!(TIMER1_ICP_PIN & (1 << TIMER1_ICP_BIT)))
+			control |= (1 << ICES1);
+	}
+	else if (edge & TIMER1_CAPTURE_RISING)
+		control |= (1 << ICES1);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_timer1Capture.both = (edge & TIMER1_CAPTURE_BOTH) ? 1 : 0;
+		_timer1Capture.head = _timer1Capture.tail;
+		TCCR1B  = control;
+		TIFR    = (1 << ICF1);
+		TIMSK  |= (1 << TICIE1);
+	}
+}
+
+/*********************************************
+Function: TIMER1_captureStop()
+Purpose:  Stop timestamping edges, the stored ones can still be read
+Input:    None
+Return:   None
+*********************************************/
+void TIMER1_captureStop(void)
+{
+	TIMSK &= ~(1 << TICIE1);
+}
+
+/*********************************************
+Function: TIMER1_captureAvailable()
+Purpose:  Get the number of edges waiting in the buffer
+Input:    None
+Return:   Number of edges
+*********************************************/
+uint8_t TIMER1_captureAvailable(void)
+{
+	return (_timer1Capture.head - _timer1Capture.tail) & TIMER1_CAPTURE_MASK;
+}
+
+/*********************************************
+Function: TIMER1_captureRead()
+Purpose:  Take the oldest edge from the buffer
+Input:    Edge to fill
+Return:   1 if an edge was read, 0 if the buffer is empty
+*********************************************/
+uint8_t TIMER1_captureRead(TIMER1_edge* edge)
+{
+	uint8_t tempTail;
+
+	if (_timer1Capture.head == _timer1Capture.tail)
+		return 0;
+	tempTail = (_timer1Capture.tail + 1) & TIMER1_CAPTURE_MASK;
+	*edge = _timer1Capture.buffer[tempTail];
+	_timer1Capture.tail = tempTail; // Free the slot after the copy
+	return 1;
+}
+
+/*********************************************
+Function: TIMER1_captureDropped()
+Purpose:  Get the number of edges lost because the buffer was full
+Input:    None
+Return:   Dropped edges
+*********************************************/
+uint16_t TIMER1_captureDropped(void)
+{
+	uint16_t dropped;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		dropped = _timer1Capture.dropped;
+	}
+	return dropped;
 }
+#endif
 
 #endif
\ No newline at end of file
@@ -2,9 +2,12 @@
 #define UART_H
 
 #include <stdio.h>
+#include <string.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 #include <util/atomic.h>
+#include "Format.h"
 
 /********************************************************************************************************************
 UDR - USART Data Register
@@ -108,146 +111,575 @@ UBRRL/UBRRH - USART Baud Rate Registers
 | URSEL  |   -    |   -    |   -    |            UBRRH[11:8]            |
 | BIT 7  | BIT 6  | BIT 5  | BIT 4  | BIT 3  | BIT 2  | BIT 1  | BIT 0  |
 |                              UBRRL[7:0]                               |
+*********************************************************************************************************************
+Baud rate selection
+	- UBRR is rounded to the nearest value for both normal (divider 16) and double speed (divider 8) mode
+	- Double speed is used only when its rate is closer to the requested one, normal mode wins ties
+	  (16 samples per bit tolerate more clock mismatch than 8)
+	- With a constant baud rate everything is folded at compile time
+	- UART_getBaudRate(port) returns the achieved rate, UART_getBaudError(port) its error in 0.01 %
+	  e.g. 16 MHz, 115200: normal UBRR 8 = 111111 (-3.5 %), double speed UBRR 16 = 117647 (+2.1 %) -> double speed
+*********************************************************************************************************************
+Ports
+	- UART_PORTS USARTs are available: 1 on ATmega8/16/32/48/88/168/328P/644, 2 on ATmega64/128/164P/324P/644P/1284P,
+	  4 on ATmega640/1280/2560
+	- Every function takes the port as first argument: UART0, UART1, UART2 or UART3
+	  e.g. UART_begin(UART1, 9600); UART_printf(UART1, "%d\n", value);
+	- Each port has its own RX & TX buffers, sized with UARTn_RX_BUFFER_SIZE / UARTn_TX_BUFFER_SIZE
+	  (power of 2, default UART_RX_BUFFER_SIZE / UART_TX_BUFFER_SIZE)
+	- All sizes can be set from the project build without editing this file, e.g. -DUART1_RX_BUFFER_SIZE=1024
+	- Indices are 8 bit while every buffer is 256 bytes or smaller, otherwise they are 16 bit and the main loop
+	  accesses the ones shared with an ISR atomically (UART_WIDE_INDEX)
+	- Each port has its own pair of ISRs, the handlers are inlined with constant registers, buffers and masks
+	  so no port lookup happens inside an interrupt
+*********************************************************************************************************************
+TX full policy, UART_setPolicy(port, policy)
+	- UART_BLOCK:       wait for the UDRE interrupt to make room (default)
+	- UART_DROP_NEWEST: drop what does not fit, the caller never waits
+	- UART_DROP_OLDEST: drop the oldest queued bytes to make room, the caller never waits
+	- Applies to write, print_P, printf, sink and the stdio stream, tryWrite never waits anyway
+	- Dropped bytes are counted in UART_stats(port).dropped
+*********************************************************************************************************************
+stdio
+	- UART_stream(port) returns a FILE* for fprintf, fputs, fgetc, etc.
+	- UART_stdio(port) binds stdin, stdout & stderr to the port so printf & puts of any library reach it
+	- Reading is non-blocking, getchar() returns EOF when the RX buffer is empty (check UART_available first)
+	- avr-libc printf is full featured and large, UART_printf (Format.h) stays the light weight option
+*********************************************************************************************************************
+RS-485 (define UART_RS485)
+	- UART_rs485(port, &PORTD, PD2) selects the driver enable (DE) pin of the transceiver
+	- DE is asserted before the first byte of a burst is queued and released from the TX complete (TXC) interrupt,
+	  which fires when the last stop bit has left the shift register, so no software delay or guard time is needed
+	- TXC only fires once the TX buffer is empty, while a burst is streaming DE stays asserted
+	- Multidrop (multi-processor communication mode, 9 bit frames)
+		- UART_multidrop(port, UART_MASTER) on the master, UART_sendAddress(port, address) before each message
+		  (the 9th bit is set only for the address byte)
+		- UART_multidrop(port, address) on slaves: MPCM makes the hardware ignore data frames until an address
+		  frame with our address (or UART_BROADCAST) arrives, the address frame itself is not stored
+	- UCSRA is written with TXC = 0 and FE/DOR/PE = 0, a read-modify-write would clear a pending TXC and leave DE on
+*********************************************************************************************************************
+RX callback (define UART_RX_CALLBACK)
+	- UART_onReceive(port, callback) calls callback(port) from the RX ISR after each stored byte
+	- Keep it short, e.g. post an event to the main loop: SCHEDULER_post(parseCommand, port) (Scheduler.h)
+	- Without UART_RX_CALLBACK the ISR has no extra pointer check
 ********************************************************************************************************************/
 
-#define UART_RX_BUFFER_SIZE ((uint8_t)128) // 128 bytes size
-#define UART_TX_BUFFER_SIZE ((uint8_t)128) // 128 bytes size
-
-#define UART_RX_BUFFER_MASK (UART_RX_BUFFER_SIZE - 1) // Used to mask received data within 0 and (buffer size - 1)
-#define UART_TX_BUFFER_MASK (UART_TX_BUFFER_SIZE - 1) // Used to mask transmitted data within 0 and (buffer size - 1)
-
-#if (UART_RX_BUFFER_SIZE & UART_RX_BUFFER_MASK)
-	#error "RX buffer size is not a power of 2"
+#ifndef UART_RX_BUFFER_SIZE
+	#define UART_RX_BUFFER_SIZE 128 // 128 bytes size, default for every port
+#endif
+#ifndef UART_TX_BUFFER_SIZE
+	#define UART_TX_BUFFER_SIZE 128 // 128 bytes size, default for every port
+#endif
+#ifndef UART0_RX_BUFFER_SIZE
+	#define UART0_RX_BUFFER_SIZE UART_RX_BUFFER_SIZE
 #endif
-#if (UART_TX_BUFFER_SIZE & UART_TX_BUFFER_MASK)
-	#error "TX buffer size is not a power of 2"
+#ifndef UART0_TX_BUFFER_SIZE
+	#define UART0_TX_BUFFER_SIZE UART_TX_BUFFER_SIZE
 #endif
+#ifndef UART1_RX_BUFFER_SIZE
+	#define UART1_RX_BUFFER_SIZE UART_RX_BUFFER_SIZE
+#endif
+#ifndef UART1_TX_BUFFER_SIZE
+	#define UART1_TX_BUFFER_SIZE UART_TX_BUFFER_SIZE
+#endif
+#ifndef UART2_RX_BUFFER_SIZE
+	#define UART2_RX_BUFFER_SIZE UART_RX_BUFFER_SIZE
+#endif
+#ifndef UART2_TX_BUFFER_SIZE
+	#define UART2_TX_BUFFER_SIZE UART_TX_BUFFER_SIZE
+#endif
+#ifndef UART3_RX_BUFFER_SIZE
+	#define UART3_RX_BUFFER_SIZE UART_RX_BUFFER_SIZE
+#endif
+#ifndef UART3_TX_BUFFER_SIZE
+	#define UART3_TX_BUFFER_SIZE UART_TX_BUFFER_SIZE
+#endif
+//#define UART_RX_OVERWRITE       // Overwrite the oldest byte instead of dropping the new one when RX buffer is full
+//#define UART_RX_CALLBACK        // Call a function from the RX ISR for every received byte
+
+#define UART_UBRR(baud, divider)      (((F_CPU) + (divider) * (baud) / 2) / ((divider) * (baud)) - 1)    // Rounded UBRR
+#define UART_RATE(baud, divider)      ((F_CPU) / ((divider) * (UART_UBRR(baud, divider) + 1)))          // Achieved rate
+#define UART_DEVIATION(baud, divider) ((UART_RATE(baud, divider) > (baud)) ? (UART_RATE(baud, divider) - (baud)) \
+                                                                          : ((baud) - UART_RATE(baud, divider)))
+#define UART_DOUBLE_SPEED(baud)       (UART_UBRR(baud, 8) <= 4095 && UART_DEVIATION(baud, 8) < UART_DEVIATION(baud, 16))
 
 #if defined(__AVR_ATmega8__)  || defined(__AVR_ATmega8A__) \
  || defined(__AVR_ATmega16__) || defined(__AVR_ATmega16A__) \
  || defined(__AVR_ATmega32__) || defined(__AVR_ATmega32A__)
 	#define ATMEGA_USART
+	#define UART_PORTS         1
 	#define UART0_RX_INTERRUPT USART_RXC_vect
 	#define UART0_TX_INTERRUPT USART_UDRE_vect
-	#define UART0_DATA         UDR
-	#define UART0_STATUS       UCSRA
-	#define UART0_CONTROL      UCSRB
-	#define UART0_UDRIE        UDRIE
+	#define UART0_TXC_INTERRUPT USART_TXC_vect
 #elif defined(__AVR_ATmega48__) || defined(__AVR_ATmega48P__) \
    || defined(__AVR_ATmega88__) || defined(__AVR_ATmega88P__) \
    || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__) || defined(__AVR_ATmega168PA__)\
    || defined(__AVR_ATmega328P__) 
 	#define ATMEGA_USART0
+	#define UART_PORTS         1
 	#define UART0_RX_INTERRUPT USART_RX_vect
 	#define UART0_TX_INTERRUPT USART_UDRE_vect
+	#define UART0_TXC_INTERRUPT USART_TX_vect
+#elif defined(__AVR_ATmega644__) || defined(__AVR_ATmega644A__)
+	#define ATMEGA_USART0
+	#define UART_PORTS         1
+	#define UART0_RX_INTERRUPT USART0_RX_vect
+	#define UART0_TX_INTERRUPT USART0_UDRE_vect
+	#define UART0_TXC_INTERRUPT USART0_TX_vect
+#elif defined(__AVR_ATmega64__)   || defined(__AVR_ATmega64A__) \
+   || defined(__AVR_ATmega128__)  || defined(__AVR_ATmega128A__) \
+   || defined(__AVR_ATmega164P__) || defined(__AVR_ATmega164PA__) \
+   || defined(__AVR_ATmega324P__) || defined(__AVR_ATmega324PA__) \
+   || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega644PA__) \
+   || defined(__AVR_ATmega1284__) || defined(__AVR_ATmega1284P__)
+	#define ATMEGA_USART0
+	#define UART_PORTS         2
+	#define UART0_RX_INTERRUPT USART0_RX_vect
+	#define UART0_TX_INTERRUPT USART0_UDRE_vect
+	#define UART0_TXC_INTERRUPT USART0_TX_vect
+	#define UART1_RX_INTERRUPT USART1_RX_vect
+	#define UART1_TX_INTERRUPT USART1_UDRE_vect
+	#define UART1_TXC_INTERRUPT USART1_TX_vect
+#elif defined(__AVR_ATmega640__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+	#define ATMEGA_USART0
+	#define UART_PORTS         4
+	#define UART0_RX_INTERRUPT USART0_RX_vect
+	#define UART0_TX_INTERRUPT USART0_UDRE_vect
+	#define UART0_TXC_INTERRUPT USART0_TX_vect
+	#define UART1_RX_INTERRUPT USART1_RX_vect
+	#define UART1_TX_INTERRUPT USART1_UDRE_vect
+	#define UART1_TXC_INTERRUPT USART1_TX_vect
+	#define UART2_RX_INTERRUPT USART2_RX_vect
+	#define UART2_TX_INTERRUPT USART2_UDRE_vect
+	#define UART2_TXC_INTERRUPT USART2_TX_vect
+	#define UART3_RX_INTERRUPT USART3_RX_vect
+	#define UART3_TX_INTERRUPT USART3_UDRE_vect
+	#define UART3_TXC_INTERRUPT USART3_TX_vect
+#else
+	#error "no UART definition for MCU available"
+#endif
+
+#if defined(ATMEGA_USART)
+	#define UART0_DATA         UDR
+	#define UART0_STATUS       UCSRA
+	#define UART0_CONTROL      UCSRB
+	#define UART0_FORMAT       UCSRC
+	#define UART0_BAUDH        UBRRH
+	#define UART0_BAUDL        UBRRL
+	// Bit positions, UCSRC shares its address with UBRRH and is selected with URSEL
+	#define UART_RXCIE         RXCIE
+	#define UART_RXEN          RXEN
+	#define UART_TXEN          TXEN
+	#define UART_UDRIE         UDRIE
+	#define UART_FE            FE
+	#define UART_DOR           DOR
+	#define UART_PE            PE
+	#define UART_U2X           U2X
+	#define UART_MPCM          MPCM
+	#define UART_TXC           TXC
+	#define UART_UDRE          UDRE
+	#define UART_TXCIE         TXCIE
+	#define UART_UCSZ2         UCSZ2
+	#define UART_RXB8          RXB8
+	#define UART_TXB8          TXB8
+	#define UART_8BIT          ((1 << URSEL) | (1 << UCSZ1) | (1 << UCSZ0))
+#elif defined(ATMEGA_USART0)
 	#define UART0_DATA         UDR0
 	#define UART0_STATUS       UCSR0A
 	#define UART0_CONTROL      UCSR0B
-	#define UART0_UDRIE        UDRIE0
+	#define UART0_FORMAT       UCSR0C
+	#define UART0_BAUDH        UBRR0H
+	#define UART0_BAUDL        UBRR0L
+	#if UART_PORTS > 1
+	#define UART1_DATA         UDR1
+	#define UART1_STATUS       UCSR1A
+	#define UART1_CONTROL      UCSR1B
+	#define UART1_FORMAT       UCSR1C
+	#define UART1_BAUDH        UBRR1H
+	#define UART1_BAUDL        UBRR1L
+	#endif
+	#if UART_PORTS > 2
+	#define UART2_DATA         UDR2
+	#define UART2_STATUS       UCSR2A
+	#define UART2_CONTROL      UCSR2B
+	#define UART2_FORMAT       UCSR2C
+	#define UART2_BAUDH        UBRR2H
+	#define UART2_BAUDL        UBRR2L
+	#define UART3_DATA         UDR3
+	#define UART3_STATUS       UCSR3A
+	#define UART3_CONTROL      UCSR3B
+	#define UART3_FORMAT       UCSR3C
+	#define UART3_BAUDH        UBRR3H
+	#define UART3_BAUDL        UBRR3L
+	#endif
+	// Bit positions are the same for every port
+	#define UART_RXCIE         RXCIE0
+	#define UART_RXEN          RXEN0
+	#define UART_TXEN          TXEN0
+	#define UART_UDRIE         UDRIE0
+	#define UART_FE            FE0
+	#define UART_DOR           DOR0
+	#define UART_PE            UPE0
+	#define UART_U2X           U2X0
+	#define UART_MPCM          MPCM0
+	#define UART_TXC           TXC0
+	#define UART_UDRE          UDRE0
+	#define UART_TXCIE         TXCIE0
+	#define UART_UCSZ2         UCSZ02
+	#define UART_RXB8          RXB80
+	#define UART_TXB8          TXB80
+	#define UART_8BIT          ((1 << UCSZ01) | (1 << UCSZ00))
+#endif
+
+#if (UART0_RX_BUFFER_SIZE & (UART0_RX_BUFFER_SIZE - 1)) || (UART0_TX_BUFFER_SIZE & (UART0_TX_BUFFER_SIZE - 1))
+	#error "UART0 buffer size is not a power of 2"
+#endif
+#if (UART_PORTS > 1) && ((UART1_RX_BUFFER_SIZE & (UART1_RX_BUFFER_SIZE - 1)) || (UART1_TX_BUFFER_SIZE & (UART1_TX_BUFFER_SIZE - 1)))
+	#error "UART1 buffer size is not a power of 2"
+#endif
+#if (UART_PORTS > 2) && ((UART2_RX_BUFFER_SIZE & (UART2_RX_BUFFER_SIZE - 1)) || (UART2_TX_BUFFER_SIZE & (UART2_TX_BUFFER_SIZE - 1)))
+	#error "UART2 buffer size is not a power of 2"
+#endif
+#if (UART_PORTS > 3) && ((UART3_RX_BUFFER_SIZE & (UART3_RX_BUFFER_SIZE - 1)) || (UART3_TX_BUFFER_SIZE & (UART3_TX_BUFFER_SIZE - 1)))
+	#error "UART3 buffer size is not a power of 2"
+#endif
+// Select the index width from the largest buffer in use
+#if (UART0_RX_BUFFER_SIZE > 256) || (UART0_TX_BUFFER_SIZE > 256) \
+ || ((UART_PORTS > 1) && ((UART1_RX_BUFFER_SIZE > 256) || (UART1_TX_BUFFER_SIZE > 256))) \
+ || ((UART_PORTS > 2) && ((UART2_RX_BUFFER_SIZE > 256) || (UART2_TX_BUFFER_SIZE > 256) \
+                       || (UART3_RX_BUFFER_SIZE > 256) || (UART3_TX_BUFFER_SIZE > 256)))
+	#define UART_WIDE_INDEX
+	typedef uint16_t UART_index;
+	#define UART_INDEX_BLOCK ATOMIC_BLOCK(ATOMIC_RESTORESTATE) // 16 bit index shared with an ISR, access it atomically
 #else
-	#error "no UART definition for MCU available"
+	typedef uint8_t UART_index;
+	#define UART_INDEX_BLOCK                                   // 8 bit access is atomic
 #endif
+#if defined(UART_RX_OVERWRITE)
+	#define UART_TAIL_BLOCK ATOMIC_BLOCK(ATOMIC_RESTORESTATE)  // RX ISR moves rxTail too when the buffer is full
+#else
+	#define UART_TAIL_BLOCK UART_INDEX_BLOCK                   // Only the reader moves rxTail
+#endif
+
+// TX full policies
+#define UART_BLOCK       0
+#define UART_DROP_NEWEST 1
+#define UART_DROP_OLDEST 2
 
-#if defined(ATMEGA_USART) || defined(ATMEGA_USART0)
-	static volatile uint8_t UART_RX_BUFFER[UART_RX_BUFFER_SIZE];
-	static volatile uint8_t UART_TX_BUFFER[UART_TX_BUFFER_SIZE];
-	static volatile uint8_t UART_RX_HEAD, UART_RX_TAIL;
-	static volatile uint8_t UART_TX_HEAD, UART_TX_TAIL;
+/*****************************************
+Port statistics
+*****************************************/
+typedef struct
+{
+	uint16_t received; // Bytes received
+	uint16_t overflow; // Bytes lost because the RX buffer was full
+	uint16_t frame;    // Frame errors (FE)
+	uint16_t overrun;  // Hardware data overruns (DOR), at least one byte lost before the ISR ran
+	uint16_t parity;   // Parity errors (PE)
+	uint16_t dropped;  // Bytes not sent because of the TX full policy
+}UART_statistics;
+
+/*****************************************
+Port state
+*****************************************/
+typedef struct UART_port
+{
+	volatile uint8_t* data;       // UDRn
+	volatile uint8_t* status;     // UCSRnA
+	volatile uint8_t* control;    // UCSRnB
+	volatile uint8_t* format;     // UCSRnC
+	volatile uint8_t* baudH;      // UBRRnH
+	volatile uint8_t* baudL;      // UBRRnL
+	volatile uint8_t* rxBuffer;
+	volatile uint8_t* txBuffer;
+	UART_index        rxMask;     // Buffer size - 1
+	UART_index        txMask;
+	volatile UART_index rxHead, rxTail;
+	volatile UART_index txHead, txTail;
+	volatile UART_statistics statistics;
+	uint32_t          baudRate;   // Achieved baud rate
+	int16_t           baudError;  // Error of the achieved baud rate in 0.01 %
+	uint8_t           policy;     // TX full policy
+	FILE              stream;     // stdio stream, set up by UART_stream()
+	#if defined(UART_RS485)
+	volatile uint8_t* dePort;     // PORTx of the driver enable pin, NULL when RS-485 is not used
+	uint8_t           deMask;
+	uint8_t           address;    // Multidrop: own address, UART_MASTER or UART_NO_MULTIDROP
+	#endif
+	#if defined(UART_RX_CALLBACK)
+	void            (*onReceive)(struct UART_port* port); // NULL when not used
+	#endif
+}UART_port;
+
+#define UART_NO_MULTIDROP 0x00 // 8 bit frames
+#define UART_MASTER       0xFE // 9 bit frames, sends addresses
+#define UART_BROADCAST    0xFF // Address accepted by every slave
+
+#define UART_PORT_STATE(n) { .data     = &UART##n##_DATA,    .status   = &UART##n##_STATUS, \
+                             .control  = &UART##n##_CONTROL, .format   = &UART##n##_FORMAT, \
+                             .baudH    = &UART##n##_BAUDH,   .baudL    = &UART##n##_BAUDL, \
+                             .rxBuffer = UART##n##_RX_BUFFER, .txBuffer = UART##n##_TX_BUFFER, \
+                             .rxMask   = UART##n##_RX_BUFFER_SIZE - 1, .txMask = UART##n##_TX_BUFFER_SIZE - 1 }
+
+static volatile uint8_t UART0_RX_BUFFER[UART0_RX_BUFFER_SIZE];
+static volatile uint8_t UART0_TX_BUFFER[UART0_TX_BUFFER_SIZE];
+#if UART_PORTS > 1
+static volatile uint8_t UART1_RX_BUFFER[UART1_RX_BUFFER_SIZE];
+static volatile uint8_t UART1_TX_BUFFER[UART1_TX_BUFFER_SIZE];
+#endif
+#if UART_PORTS > 2
+static volatile uint8_t UART2_RX_BUFFER[UART2_RX_BUFFER_SIZE];
+static volatile uint8_t UART2_TX_BUFFER[UART2_TX_BUFFER_SIZE];
+static volatile uint8_t UART3_RX_BUFFER[UART3_RX_BUFFER_SIZE];
+static volatile uint8_t UART3_TX_BUFFER[UART3_TX_BUFFER_SIZE];
 #endif
 
-#if defined(ATMEGA_USART) || defined(ATMEGA_USART0)
+static UART_port _uart[UART_PORTS] =
+{
+	UART_PORT_STATE(0),
+	#if UART_PORTS > 1
+	UART_PORT_STATE(1),
+	#endif
+	#if UART_PORTS > 2
+	UART_PORT_STATE(2),
+	UART_PORT_STATE(3),
+	#endif
+};
+
+#define UART0 (&_uart[0])
+#if UART_PORTS > 1
+	#define UART1 (&_uart[1])
+#endif
+#if UART_PORTS > 2
+	#define UART2 (&_uart[2])
+	#define UART3 (&_uart[3])
+#endif
 
 /*********************
 Glossary of functions
 *********************/
-void     UART_begin    (uint32_t _baudrate);
-uint16_t UART_available(void);
-void     UART_flush    (void);
-void     UART_printf   (char* format, ...);
-static void print(const char* s);
-static void send (const char c);
-
-//uint8_t UART_Read_Char  (void);
-//uint8_t UART_Read_String(char* _string);
+static inline uint32_t UART_begin(UART_port* port, uint32_t _baudrate) __attribute__((always_inline));
+uint32_t UART_getBaudRate (UART_port* port);
+int16_t  UART_getBaudError(UART_port* port);
+uint16_t UART_available(UART_port* port);
+void     UART_flush    (UART_port* port);
+void     UART_printf   (UART_port* port, char* format, ...);
+void     UART_write    (UART_port* port, const uint8_t* data, uint16_t length);
+uint16_t UART_tryWrite (UART_port* port, const uint8_t* data, uint16_t length);
+void     UART_print_P  (UART_port* port, const char* s);
+void     UART_sink     (void* port, char c);
+void     UART_setPolicy(UART_port* port, uint8_t policy);
+FILE*    UART_stream   (UART_port* port);
+void     UART_stdio    (UART_port* port);
+#if defined(UART_RS485)
+void     UART_rs485    (UART_port* port, volatile uint8_t* dePort, uint8_t dePin);
+void     UART_multidrop(UART_port* port, uint8_t address);
+void     UART_sendAddress(UART_port* port, uint8_t address);
+static inline void release(UART_port* port) __attribute__((always_inline));
+#endif
+#if defined(UART_RX_CALLBACK)
+void     UART_onReceive(UART_port* port, void (*callback)(UART_port* port));
+#endif
+int16_t  UART_read     (UART_port* port);
+int16_t  UART_peek     (UART_port* port);
+uint16_t UART_readBytes(UART_port* port, uint8_t* buffer, uint16_t length);
+int16_t  UART_readFrame(UART_port* port, char* frame, uint16_t size, char delimiter);
+UART_statistics UART_stats(UART_port* port);
+void     UART_clearStats(UART_port* port);
+static void     send (UART_port* port, const char c);
+static void     start(UART_port* port);
+static void     queue(UART_port* port, const uint8_t* data, uint16_t length, uint8_t flash);
+static uint8_t  full (UART_port* port, uint16_t length);
+static int      put  (char c, FILE* stream);
+static int      get  (FILE* stream);
+static uint16_t push (UART_port* port, const uint8_t* data, uint16_t length, uint8_t flash);
+static void     configure(UART_port* port, uint16_t _ubrr, uint8_t _doubleSpeed);
+static inline void receive (UART_port* port, volatile uint8_t* data, volatile uint8_t* status,
+                            volatile uint8_t* control, volatile uint8_t* buffer, UART_index mask) __attribute__((always_inline));
+static inline void transmit(UART_port* port, volatile uint8_t* data, volatile uint8_t* control,
+                            volatile uint8_t* buffer, UART_index mask) __attribute__((always_inline));
 
 /************************
 Function: Interrupt Service Routines
-Purpose:  Handling interrupts of UART0
+Purpose:  Handling interrupts of every port, each one with its own constant registers and buffers
 Input:    Interrupt vector
 Return:   None
 ************************/
-ISR (UART0_RX_INTERRUPT)
+#define UART_INTERRUPTS(n) \
+	ISR (UART##n##_RX_INTERRUPT) \
+	{ \
+		receive(&_uart[n], &UART##n##_DATA, &UART##n##_STATUS, &UART##n##_CONTROL, \
+		        UART##n##_RX_BUFFER, UART##n##_RX_BUFFER_SIZE - 1); \
+	} \
+	ISR (UART##n##_TX_INTERRUPT) \
+	{ \
+		transmit(&_uart[n], &UART##n##_DATA, &UART##n##_CONTROL, UART##n##_TX_BUFFER, UART##n##_TX_BUFFER_SIZE - 1); \
+	} \
+	UART_TXC_INTERRUPT(n)
+
+#if defined(UART_RS485)
+	#define UART_TXC_INTERRUPT(n) \
+	ISR (UART##n##_TXC_INTERRUPT) \
+	{ \
+		release(&_uart[n]); \
+	}
+#else
+	#define UART_TXC_INTERRUPT(n)
+#endif
+
+UART_INTERRUPTS(0)
+#if UART_PORTS > 1
+UART_INTERRUPTS(1)
+#endif
+#if UART_PORTS > 2
+UART_INTERRUPTS(2)
+UART_INTERRUPTS(3)
+#endif
+
+/***************************************************
+Function: receive()
+Purpose:  RX complete handler, store the received byte and count errors
+Input:    Port, its data, status & control registers, its RX buffer and buffer mask
+Return:   None
+***************************************************/
+static inline void receive(UART_port* port, volatile uint8_t* data, volatile uint8_t* status,
+                           volatile uint8_t* control, volatile uint8_t* buffer, UART_index mask)
 {
-	uint8_t _tempHead;
+	UART_index _tempHead;
+	uint8_t _status;
 	uint8_t _data;
+	#if defined(UART_RS485)
+	uint8_t _ninth;
+	#endif
 	
-	#if defined(ATMEGA_USART) || defined(ATMEGA_USART0)
-	_data = UART0_DATA;
+	_status = *status; // Error flags belong to the byte in UDR, read them first
+	#if defined(UART_RS485)
+	_ninth  = *control & (1 << UART_RXB8); // So does the 9th bit
+	#endif
+	_data   = *data;
+	port->statistics.received++;
+	if (_status & (1 << UART_FE))  port->statistics.frame++;
+	if (_status & (1 << UART_DOR)) port->statistics.overrun++;
+	if (_status & (1 << UART_PE))  port->statistics.parity++;
+	#if defined(UART_RS485)
+	if (_ninth && port->address != UART_NO_MULTIDROP && port->address != UART_MASTER)
+	{
+		// Address frame: listen to the following data frames only when it is for us
+		if (_data == port->address || _data == UART_BROADCAST)
+			*status = _status & (1 << UART_U2X);
+		else
+			*status = (_status & (1 << UART_U2X)) | (1 << UART_MPCM);
+		return;
+	}
 	#endif
 	// Calculate buffer index
-	_tempHead = (UART_RX_HEAD + 1) & UART_RX_BUFFER_MASK;
+	_tempHead = (port->rxHead + 1) & mask;
 	
-	UART_RX_HEAD = _tempHead;
-	UART_RX_BUFFER[_tempHead] = _data;
+	if (_tempHead == port->rxTail)
+	{
+		port->statistics.overflow++;
+		#if defined(UART_RX_OVERWRITE)
+		port->rxTail = (port->rxTail + 1) & mask; // Drop the oldest byte
+		#else
+		return;                                   // Drop the new byte
+		#endif
+	}
+	buffer[_tempHead] = _data;
+	port->rxHead = _tempHead;
+	#if defined(UART_RX_CALLBACK)
+	if (port->onReceive)
+		port->onReceive(port);
+	#endif
 }
-ISR (UART0_TX_INTERRUPT)
+
+/***************************************************
+Function: transmit()
+Purpose:  Data register empty handler, send the next byte or stop when the TX buffer is empty
+Input:    Port, its data & control registers, its TX buffer and buffer mask
+Return:   None
+***************************************************/
+static inline void transmit(UART_port* port, volatile uint8_t* data, volatile uint8_t* control,
+                            volatile uint8_t* buffer, UART_index mask)
 {
-	uint8_t _tempTail;
+	UART_index _tempTail;
 	
-	if (UART_TX_HEAD != UART_TX_TAIL)
+	if (port->txHead != port->txTail)
 	{
 		// Calculate buffer index
-		_tempTail = (UART_TX_TAIL + 1) & UART_TX_BUFFER_MASK;
-		UART_TX_TAIL = _tempTail;
+		_tempTail = (port->txTail + 1) & mask;
+		port->txTail = _tempTail;
 		// Transmit data
-		#if defined(ATMEGA_USART) || defined(ATMEGA_USART0)
-		UART0_DATA = UART_TX_BUFFER[_tempTail];
-		#endif
+		*data = buffer[_tempTail];
 	}
 	else
 	{
-		#if defined(ATMEGA_USART) || defined(ATMEGA_USART0)
-		UART0_CONTROL &= ~(1 << UART0_UDRIE); // Disable UDRE interrupts
-		#endif
+		*control &= ~(1 << UART_UDRIE); // Disable UDRE interrupts
 	}
 }
 
 /*****************************************
 Function: begin()
 Purpose:  Initialize UART and set baud rate
-Input:    Baud rate: 9600, 115200, etc.
+Input:    Port, baud rate: 9600, 115200, 250000, 1000000, etc.
+Return:   Achieved baud rate
+*****************************************/
+static inline uint32_t UART_begin(UART_port* port, uint32_t _baudrate)
+{
+	uint8_t _doubleSpeed = UART_DOUBLE_SPEED(_baudrate);
+	uint8_t _divider     = _doubleSpeed ? 8 : 16;
+	
+	port->baudRate  = UART_RATE(_baudrate, _divider);
+	port->baudError = ((int32_t)port->baudRate - (int32_t)_baudrate) * 100 / (int32_t)(_baudrate / 100);
+	configure(port, UART_UBRR(_baudrate, _divider), _doubleSpeed);
+	return port->baudRate;
+}
+
+/*****************************************
+Function: getBaudRate()
+Purpose:  Get the achieved baud rate
+Input:    Port
+Return:   Baud rate
+*****************************************/
+uint32_t UART_getBaudRate(UART_port* port)
+{
+	return port->baudRate;
+}
+
+/*****************************************
+Function: getBaudError()
+Purpose:  Get the error of the achieved baud rate
+Input:    Port
+Return:   Error in 0.01 % (e.g. -350 = -3.5 %)
+*****************************************/
+int16_t UART_getBaudError(UART_port* port)
+{
+	return port->baudError;
+}
+
+/*****************************************
+Function: configure()
+Purpose:  Reset buffers, set baud rate registers and enable UART
+Input:    Port, UBRR value, 1 for double speed mode
 Return:   None
 *****************************************/
-void UART_begin(uint32_t _baudrate)
+static void configure(UART_port* port, uint16_t _ubrr, uint8_t _doubleSpeed)
 {
 	ATOMIC_BLOCK(ATOMIC_FORCEON)
 	{
-		UART_RX_HEAD = 0;
-		UART_RX_TAIL = 0;
-		UART_TX_HEAD = 0;
-		UART_TX_TAIL = 0;
+		port->rxHead = 0;
+		port->rxTail = 0;
+		port->txHead = 0;
+		port->txTail = 0;
 	}
-	// Set prescaler
-	uint16_t _prescale = (F_CPU / 16 / _baudrate) - 1;
+	// Select normal or double speed mode, clear MPCM
+	*port->status = _doubleSpeed ? (1 << UART_U2X) : 0;
 	
-	#if defined(ATMEGA_USART)
-		UBRRH = (uint8_t)(_prescale >> 8);
-		UBRRL = (uint8_t)_prescale;
-		// Enable RX & TX with Interrupts
-		UART0_CONTROL |= (1 << RXEN) | (1 << RXCIE) | (1 << TXEN);
-		// Select UCSRC Register & use 8 bit size
-		UCSRC |= (1 << URSEL) | (1 << UCSZ1) | (1 << UCSZ0);
-	#elif defined(ATMEGA_USART0)
-		UBRR0H = (uint8_t)(_prescale >> 8);
-		UBRR0L = (uint8_t)_prescale;
-		// Enable RX & TX with Interrupts
-		UART0_CONTROL |= (1 << RXEN0) | (1 << RXCIE0) | (1 << TXEN0);
-		#if defined(URSEL0)
-			UCSR0C |= (1 << URSEL0) | (1 << UCSZ01) | (1 << UCSZ00);
-		#else
-			UCSR0C |= (1 << UCSZ01) | (1 << UCSZ00);
-		#endif
-	#endif
+	*port->baudH = (uint8_t)(_ubrr >> 8);
+	*port->baudL = (uint8_t)_ubrr;
+	// Enable RX & TX with Interrupts
+	*port->control |= (1 << UART_RXEN) | (1 << UART_RXCIE) | (1 << UART_TXEN);
+	// Asynchronous, no parity, 1 stop bit, 8 bit size
+	*port->format = UART_8BIT;
 	// Enable global interrupts
 	sei();
 }
@@ -255,15 +687,15 @@ void UART_begin(uint32_t _baudrate)
 /***************************************************************
 Function: available()
 Purpose:  Get the number of bytes waiting in the receiver buffer
-Input:    None
+Input:    Port
 Return:   Number of bytes waiting in the receiver buffer
 ***************************************************************/
-uint16_t UART_available(void)
+uint16_t UART_available(UART_port* port)
 {
-	uint8_t _ret;
+	uint16_t _ret;
 	ATOMIC_BLOCK(ATOMIC_FORCEON)
 	{
-		_ret = (UART_RX_BUFFER_SIZE + UART_RX_HEAD - UART_RX_TAIL) & UART_RX_BUFFER_MASK;
+		_ret = (port->rxHead - port->rxTail) & port->rxMask;
 	}
 	return _ret;
 }
@@ -271,129 +703,540 @@ uint16_t UART_available(void)
 /***************************************************
 Function: flush()
 Purpose:  Flush bytes waiting in the receiver buffer
-Input:    None
+Input:    Port
+Return:   None
+***************************************************/
+void UART_flush(UART_port* port)
+{
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		port->rxTail = port->rxHead;
+	}
+}
+
+/***************************************************
+Function: read()
+Purpose:  Read one byte from the receiver buffer
+Input:    Port
+Return:   Byte read or -1 if the buffer is empty
+***************************************************/
+int16_t UART_read(UART_port* port)
+{
+	UART_index _head, _tail, _tempTail;
+	uint8_t    _data;
+	
+	UART_TAIL_BLOCK
+	{
+		_head = port->rxHead;
+		_tail = port->rxTail;
+	}
+	if (_head == _tail)
+		return -1;
+	_tempTail = (_tail + 1) & port->rxMask;
+	_data = port->rxBuffer[_tempTail];
+	UART_TAIL_BLOCK
+	{
+		if (port->rxTail == _tail)         // Otherwise an overwrite already dropped the byte
+			port->rxTail = _tempTail;
+	}
+	return _data;
+}
+
+/***************************************************
+Function: peek()
+Purpose:  Get the next byte without removing it from the receiver buffer
+Input:    Port
+Return:   Next byte or -1 if the buffer is empty
+***************************************************/
+int16_t UART_peek(UART_port* port)
+{
+	UART_index _head, _tail;
+	
+	UART_TAIL_BLOCK
+	{
+		_head = port->rxHead;
+		_tail = port->rxTail;
+	}
+	if (_head == _tail)
+		return -1;
+	return port->rxBuffer[(_tail + 1) & port->rxMask];
+}
+
+/***************************************************
+Function: stats()
+Purpose:  Get a snapshot of the port statistics
+Input:    Port
+Return:   Port statistics
+***************************************************/
+UART_statistics UART_stats(UART_port* port)
+{
+	UART_statistics _stats;
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		_stats = *(const UART_statistics*)&port->statistics;
+	}
+	return _stats;
+}
+
+/***************************************************
+Function: clearStats()
+Purpose:  Reset the port statistics
+Input:    Port
 Return:   None
 ***************************************************/
-void UART0_flush(void)
+void UART_clearStats(UART_port* port)
 {
 	ATOMIC_BLOCK(ATOMIC_FORCEON)
 	{
-		UART_RX_HEAD = UART_RX_TAIL;
+		*(UART_statistics*)&port->statistics = (UART_statistics){0};
 	}
 }
 
+/***************************************************
+Function: readBytes()
+Purpose:  Drain up to length bytes from the receiver buffer in one critical section
+Input:    Port, buffer for the data, size of the buffer
+Return:   Amount of bytes read
+***************************************************/
+uint16_t UART_readBytes(UART_port* port, uint8_t* buffer, uint16_t length)
+{
+	UART_index _start;
+	uint16_t   _available, _first;
+	
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		_available = (port->rxHead - port->rxTail) & port->rxMask;
+		if (length > _available)
+			length = _available;
+		// Copy up to the end of the buffer, then the rest from the beginning
+		_start = (port->rxTail + 1) & port->rxMask;
+		_first = port->rxMask + 1 - _start;
+		if (_first > length)
+			_first = length;
+		memcpy(buffer, (const uint8_t*)&port->rxBuffer[_start], _first);
+		memcpy(buffer + _first, (const uint8_t*)port->rxBuffer, length - _first);
+		port->rxTail = (port->rxTail + length) & port->rxMask;
+	}
+	return length;
+}
+
+/***************************************************
+Function: readFrame()
+Purpose:  Read a delimiter terminated frame (e.g. an ASCII RFID frame) from the receiver buffer
+Input:    Port, buffer for the frame, size of the buffer, delimiter
+Return:   Length of the frame (without delimiter, null terminated, truncated to size - 1)
+          or -1 if no complete frame was received yet or size is 0 (nothing is read)
+***************************************************/
+int16_t UART_readFrame(UART_port* port, char* frame, uint16_t size, char delimiter)
+{
+	UART_index _head, _tail, _index;
+	uint8_t    _found  = 0;
+	uint16_t   _length = 0;
+	int16_t    _ret    = -1;
+	
+	if (!size)                             // No room even for the null
+		return -1;
+	UART_TAIL_BLOCK
+	{
+		_head = port->rxHead;
+		_tail = port->rxTail;
+	}
+	_index = _tail;
+
+	// Find the delimiter
+	while (_index != _head)
+	{
+		_index = (_index + 1) & port->rxMask;
+		if (port->rxBuffer[_index] == (uint8_t)delimiter)
+		{
+			_found = 1;
+			break;
+		}
+		_length++;
+	}
+	if (!_found)
+	{
+		if (_length == port->rxMask)   // Buffer full without delimiter, drop it to resynchronize
+		{
+			UART_TAIL_BLOCK
+			{
+				if (port->rxTail == _tail)
+					port->rxTail = _head;
+			}
+		}
+		return -1;
+	}
+	// Copy the frame and consume it together with the delimiter
+	if (_length > size - 1)
+		_length = size - 1;
+	for (uint16_t i = 0; i < _length; i++)
+		frame[i] = port->rxBuffer[(_tail + 1 + i) & port->rxMask];
+	frame[_length] = '\0';
+	UART_TAIL_BLOCK
+	{
+		if (port->rxTail == _tail)         // Otherwise an overwrite dropped the start of the frame while copying
+		{
+			port->rxTail = _index;
+			_ret = _length;
+		}
+	}
+	return _ret;
+}
+
 /***************************************************
 Function: printf()
-Purpose:  Printf emulation for UART
-Input:    Format, arguments, etc.
+Purpose:  Printf emulation for UART, see Format.h for the conversions
+Input:    Port, format, arguments, etc.
 Return:   None
 ***************************************************/
-void UART_printf(char* format, ...)
+void UART_printf(UART_port* port, char* format, ...)
 {
-	char buffer[UART_RX_BUFFER_SIZE];
 	va_list args;
 	va_start(args, format);
-	vsnprintf(buffer, UART_RX_BUFFER_SIZE, format, args);
+	FORMAT_vprint(UART_sink, port, format, args);
 	va_end(args);
-	print(buffer);
 }
 
 /***************************************************
-Function: print()
-Purpose:  Static handler for printf
-Input:    Pointer to char
+Function: sink()
+Purpose:  Formatter sink, queue one char for transmission
+Input:    Port, char to be sent
+Return:   None
+***************************************************/
+void UART_sink(void* port, char c)
+{
+	send((UART_port*)port, c);
+}
+
+/***************************************************
+Function: setPolicy()
+Purpose:  Select what happens when the transmitter buffer is full
+Input:    Port, UART_BLOCK, UART_DROP_NEWEST or UART_DROP_OLDEST
+Return:   None
+***************************************************/
+void UART_setPolicy(UART_port* port, uint8_t policy)
+{
+	port->policy = policy;
+}
+
+#if defined(UART_RX_CALLBACK)
+/***************************************************
+Function: onReceive()
+Purpose:  Set the function called from the RX ISR after each stored byte
+Input:    Port, callback or NULL to remove it
+Return:   None
+***************************************************/
+void UART_onReceive(UART_port* port, void (*callback)(UART_port* port))
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		port->onReceive = callback;
+	}
+}
+#endif
+
+/***************************************************
+Function: stream()
+Purpose:  Get a stdio stream of the port
+Input:    Port
+Return:   Stream for fprintf, fputs, fgetc, etc.
+***************************************************/
+FILE* UART_stream(UART_port* port)
+{
+	fdev_setup_stream(&port->stream, put, get, _FDEV_SETUP_RW);
+	fdev_set_udata(&port->stream, port);
+	return &port->stream;
+}
+
+/***************************************************
+Function: stdio()
+Purpose:  Bind stdin, stdout & stderr to the port
+Input:    Port
 Return:   None
 ***************************************************/
-static void print(const char* s)
+void UART_stdio(UART_port* port)
 {
-	while (*s)
-		send(*s++);
+	stdin = stdout = stderr = UART_stream(port);
+}
+
+/***************************************************
+Function: write()
+Purpose:  Copy a buffer into the transmitter buffer, the TX full policy decides when it is full
+Input:    Port, pointer to data, amount of bytes
+Return:   None
+***************************************************/
+void UART_write(UART_port* port, const uint8_t* data, uint16_t length)
+{
+	queue(port, data, length, 0);
+}
+
+/***************************************************
+Function: tryWrite()
+Purpose:  Copy as much of a buffer as fits into the transmitter buffer without waiting
+Input:    Port, pointer to data, amount of bytes
+Return:   Amount of bytes accepted
+***************************************************/
+uint16_t UART_tryWrite(UART_port* port, const uint8_t* data, uint16_t length)
+{
+	return push(port, data, length, 0);
+}
+
+/***************************************************
+Function: print_P()
+Purpose:  Send a string stored in flash without copying it to SRAM
+Input:    Port, pointer to string in flash (PSTR("..."))
+Return:   None
+***************************************************/
+void UART_print_P(UART_port* port, const char* s)
+{
+	queue(port, (const uint8_t*)s, strlen_P(s), 1);
 }
 
 /***************************************************
 Function: send()
-Purpose:  Static handler for print
-Input:    Char to be sent
+Purpose:  Static handler for sink
+Input:    Port, char to be sent
 Return:   None
 ***************************************************/
-static void send(const char c)
+static void send(UART_port* port, const char c)
 {
-	uint8_t _tempHead;
-	_tempHead = (UART_TX_HEAD + 1) & UART_TX_BUFFER_MASK;
-	// Wait for free space in buffer
-	while (_tempHead == UART_TX_TAIL);
+	UART_index _tempHead, _tail;
+	_tempHead = (port->txHead + 1) & port->txMask;
+	// Wait for free space in buffer, or make room, or give up
+	do
+	{
+		UART_INDEX_BLOCK
+		{
+			_tail = port->txTail;
+		}
+	}while (_tempHead == _tail && full(port, 1));
+	if (_tempHead == _tail)
+	{
+		port->statistics.dropped++;
+		return;
+	}
 	
-	UART_TX_BUFFER[_tempHead] = c;
-	UART_TX_HEAD = _tempHead;
-
-	// Enable UDRE interrupts
-	#if defined(ATMEGA_USART) || defined(ATMEGA_USART0)
-	UART0_CONTROL |= (1 << UART0_UDRIE);
-	#endif
+	port->txBuffer[_tempHead] = c;
+	UART_INDEX_BLOCK
+	{
+		port->txHead = _tempHead;
+	}
+	start(port);
 }
 
-/************************************
-Function: UART0_Read_Char
-Purpose:  Read char from ring buffer
-Input:    None
-Return:   Data to be read
-************************************/
-/*
-uint8_t UART0_Read_Char(void)
+/***************************************************
+Function: push()
+Purpose:  Block copy into the transmitter buffer, wrapping at most once
+Input:    Port, pointer to data, amount of bytes, 1 if data is in flash
+Return:   Amount of bytes copied
+***************************************************/
+static uint16_t push(UART_port* port, const uint8_t* data, uint16_t length, uint8_t flash)
 {
-	uint8_t _tempTail;
-	uint8_t _data;
+	UART_index _start = (port->txHead + 1) & port->txMask;
+	UART_index _tail;
+	uint16_t   _free, _first;
 	
-	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	UART_INDEX_BLOCK
 	{
-		if (UART_RX_HEAD == UART_RX_TAIL) 
-			return 0; // might just return null char??
+		_tail = port->txTail;
 	}
-	_tempTail = (UART_RX_TAIL + 1) & UART_RX_BUFFER_MASK;
+	_free = (_tail - _start) & port->txMask;
 
-	UART_RX_TAIL = _tempTail;
-	_data = UART_RX_BUFFER[_tempTail];
-	return _data;
-}*/
-
-/****************************************
-Function: UART0_Read_String
-Purpose:  Read string from ring buffer
-Input:    String that holds the read data
-Return:   State of data that's read
-****************************************/
-/*
-uint8_t UART0_Read_String(char* _string)
-{
-	while (UART_available() > 0)
+	if (length > _free)
+		length = _free;
+	if (!length)
+		return 0;
+	// Copy up to the end of the buffer, then the rest from the beginning
+	_first = port->txMask + 1 - _start;
+	if (_first > length)
+		_first = length;
+	if (flash)
+	{
+		memcpy_P((uint8_t*)&port->txBuffer[_start], data, _first);
+		memcpy_P((uint8_t*)port->txBuffer, data + _first, length - _first);
+	}
+	else
 	{
-		char _byte = UART0_Read_Char();
-		if (_byte != '>') _strncat(_string, &_byte, 1);
-		else return 1;
+		memcpy((uint8_t*)&port->txBuffer[_start], data, _first);
+		memcpy((uint8_t*)port->txBuffer, data + _first, length - _first);
 	}
+	UART_INDEX_BLOCK
+	{
+		port->txHead = (port->txHead + length) & port->txMask;
+	}
+	start(port);
+	return length;
+}
+
+/***************************************************
+Function: queue()
+Purpose:  Copy a buffer into the transmitter buffer, applying the TX full policy
+Input:    Port, pointer to data, amount of bytes, 1 if data is in flash
+Return:   None
+***************************************************/
+static void queue(UART_port* port, const uint8_t* data, uint16_t length, uint8_t flash)
+{
+	uint16_t _accepted;
+	while (length)
+	{
+		_accepted = push(port, data, length, flash);
+		data   += _accepted;
+		length -= _accepted;
+		if (length && !full(port, length))
+		{
+			port->statistics.dropped += length;
+			return;
+		}
+	}
+}
+
+/***************************************************
+Function: full()
+Purpose:  Handle a full transmitter buffer according to the TX full policy
+Input:    Port, amount of bytes waiting to be queued
+Return:   1 to try again, 0 to drop the bytes
+***************************************************/
+static uint8_t full(UART_port* port, uint16_t length)
+{
+	uint16_t _queued;
+
+	switch (port->policy)
+	{
+		case UART_DROP_NEWEST:
+			return 0;
+		case UART_DROP_OLDEST:
+			// Skip the oldest bytes not yet moved to UDR
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				_queued = (port->txHead - port->txTail) & port->txMask;
+				if (length > _queued)
+					length = _queued;
+				port->txTail = (port->txTail + length) & port->txMask;
+				port->statistics.dropped += length;
+			}
+			return 1;
+		default:
+			return 1; // Block, the UDRE interrupt makes room
+	}
+}
+
+/***************************************************
+Function: put()
+Purpose:  stdio handler, send one char
+Input:    Char, stream
+Return:   0
+***************************************************/
+static int put(char c, FILE* stream)
+{
+	send((UART_port*)fdev_get_udata(stream), c);
 	return 0;
-}*/
+}
 
-/***************
-Inline functions
-***************/
+/***************************************************
+Function: get()
+Purpose:  stdio handler, read one char without waiting
+Input:    Stream
+Return:   Char or _FDEV_EOF if the receiver buffer is empty
+***************************************************/
+static int get(FILE* stream)
+{
+	int16_t _data = UART_read((UART_port*)fdev_get_udata(stream));
+	return (_data < 0) ? _FDEV_EOF : _data;
+}
 
-/*
-static char* _strncat(char* _destination, const char* _source, size_t _n)
+/***************************************************
+Function: start()
+Purpose:  Start sending the transmitter buffer, assert DE first in RS-485 mode
+Input:    Port
+Return:   None
+***************************************************/
+static void start(UART_port* port)
+{
+	#if defined(UART_RS485)
+	if (port->dePort)
+		*port->dePort |= port->deMask;
+	#endif
+	// Enable UDRE interrupts
+	*port->control |= (1 << UART_UDRIE);
+}
+
+#if defined(UART_RS485)
+/***************************************************
+Function: rs485()
+Purpose:  Enable RS-485 mode, drive DE while transmitting
+Input:    Port, PORTx register of the DE pin, pin number
+Return:   None
+***************************************************/
+void UART_rs485(UART_port* port, volatile uint8_t* dePort, uint8_t dePin)
+{
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		port->dePort  = dePort;
+		port->deMask  = (1 << dePin);
+		*dePort      &= ~port->deMask;
+		*(dePort - 1) |= port->deMask;                          // DDRx is right below PORTx on every AVR
+		// Clear a stale TXC flag (written as 1), keep U2X & MPCM
+		*port->status  = (*port->status & ((1 << UART_U2X) | (1 << UART_MPCM))) | (1 << UART_TXC);
+		*port->control |= (1 << UART_TXCIE);
+	}
+}
+
+/***************************************************
+Function: multidrop()
+Purpose:  Switch to 9 bit frames for multi-processor communication
+Input:    Port, own slave address (1 - 0xFD), UART_MASTER or UART_NO_MULTIDROP to go back to 8 bit frames
+Return:   None
+***************************************************/
+void UART_multidrop(UART_port* port, uint8_t address)
 {
-	char* _p = _destination + _strlen(_destination); // Point to the end of the destination string
-	while (* _source != '0' && _n--)				// Concatenate the char into the string
-		*_p++ = *_source++;
-	*_p = '\0';										// Null terminate the pointer
-	return _destination;                            // Return the destination string
+	uint8_t _u2x = *port->status & (1 << UART_U2X);
+
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		port->address = address;
+		if (address == UART_NO_MULTIDROP)
+			*port->control &= ~((1 << UART_UCSZ2) | (1 << UART_TXB8));
+		else
+			*port->control = (*port->control & ~(1 << UART_TXB8)) | (1 << UART_UCSZ2);
+		// Slaves wait for an address frame
+		*port->status = (address == UART_NO_MULTIDROP || address == UART_MASTER) ? _u2x : (_u2x | (1 << UART_MPCM));
+	}
+}
+
+/***************************************************
+Function: sendAddress()
+Purpose:  Master: address a slave, waits until the previous message has left the bus
+Input:    Port, slave address or UART_BROADCAST
+Return:   None
+***************************************************/
+void UART_sendAddress(UART_port* port, uint8_t address)
+{
+	// Wait for the transmitter buffer to drain and DE to be released by TXC
+	while (port->txHead != port->txTail || (port->dePort && (*port->dePort & port->deMask)));
+	while (!(*port->status & (1 << UART_UDRE)));
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		if (port->dePort)
+			*port->dePort |= port->deMask;
+		*port->control |= (1 << UART_TXB8);
+		*port->data     = address;
+	}
+	// The 9th bit is taken together with the byte once it moves into the shift register
+	while (!(*port->status & (1 << UART_UDRE)));
+	*port->control &= ~(1 << UART_TXB8);
 }
 
-static uint8_t _strlen(char* _string)
+/***************************************************
+Function: release()
+Purpose:  TX complete handler, release DE after the last stop bit unless more data was queued meanwhile
+Input:    Port
+Return:   None
+***************************************************/
+static inline void release(UART_port* port)
 {
-	uint8_t _len = 0;                      // Make sure length is 0 by default
-	for (; _string[_len] != '\0'; _len++); // While not a null char increase the length
-	return _len;                           // Return the length
-}*/
+	if (port->txHead == port->txTail && port->dePort)
+		*port->dePort &= ~port->deMask;
+}
+#endif
 
 #endif
-#endif
\ No newline at end of file
@@ -9,9 +9,9 @@
 Function prototypes
 *********************************************/
 void    AT24C32_begin(void);
-uint8_t AT24C32_write(uint8_t address, uint8_t data);
-uint8_t AT24C32_read (uint8_t address);
-void    AT24C32_readArray(uint8_t address, uint8_t* data , size_t size);
+uint8_t AT24C32_write(uint16_t address, uint8_t data);
+uint8_t AT24C32_read (uint16_t address);
+uint8_t AT24C32_readArray(uint16_t address, uint8_t* data, size_t size);
 
 /*********************************************
 Function: begin()
@@ -26,10 +26,10 @@ void AT24C32_begin(void)
 /*********************************************
 Function: write()
 Purpose:  Write byte of data to a specific address
-Input:    Address and data
-Return:   1 if successfull and 0 if not successfull (already same value in that register)
+Input:    Address (0 - 4095) and data
+Return:   1 if written and 0 if not written (already same value in that register or the transfer failed)
 *********************************************/
-uint8_t AT24C32_write(uint8_t address, uint8_t data)
+uint8_t AT24C32_write(uint16_t address, uint8_t data)
 {
 	uint8_t readValue = AT24C32_read(address);
 	if (data != readValue)
@@ -38,7 +38,8 @@ uint8_t AT24C32_write(uint8_t address, uint8_t data)
 		TWI_write(address >> 8);
 		TWI_write(address);
 		TWI_write(data);
-		TWI_endTransmission();
+		if (TWI_endTransmission() != TWI_OK)
+			return 0;
 		_delay_ms(5);
 		return 1;
 	}
@@ -48,24 +49,41 @@ uint8_t AT24C32_write(uint8_t address, uint8_t data)
 /*********************************************
 Function: read()
 Purpose:  Read byte of data from a specific address
-Input:    Address where reading is requested
-Return:   Data
+Input:    Address where reading is requested (0 - 4095)
+Return:   Data, 0 if the transfer failed
 *********************************************/
-uint8_t AT24C32_read(uint8_t address)
+uint8_t AT24C32_read(uint16_t address)
 {
-	TWI_beginTransmission(AT24C32_ADDRESS);
-	TWI_write(address >> 8);
-	TWI_write(address);
-	TWI_requestFrom(AT24C32_ADDRESS, 1);
-	return (TWI_read());
+	uint8_t data = 0;
+	AT24C32_readArray(address, &data, 1);
+	return data;
 }
 
-void AT24C32_readArray(uint8_t address, uint8_t* data, size_t size)
+/*********************************************
+Function: readArray()
+Purpose:  Sequential read of consecutive addresses (address write, repeated START, burst read)
+Input:    First address (0 - 4095), buffer for the data and amount of bytes
+Return:   TWI_OK or the status of the first failed transfer (the rest of the buffer is not read)
+*********************************************/
+uint8_t AT24C32_readArray(uint16_t address, uint8_t* data, size_t size)
 {
-	while (size--)
+	uint8_t memoryAddress[2];
+	uint8_t status;
+	TWI_transaction transaction = {.address = AT24C32_ADDRESS, .writeBuffer = memoryAddress, .writeLength = 2};
+	while (size)
 	{
-		*data++ = AT24C32_read(address++);
+		memoryAddress[0] = (address >> 8) & 0x0F;
+		memoryAddress[1] = address;
+		transaction.readBuffer = data;
+		transaction.readLength = (size > 0xFF) ? 0xFF : size;
+		status = TWI_transfer(&transaction);
+		if (status != TWI_OK)
+			return status;
+		address += transaction.readLength;
+		data    += transaction.readLength;
+		size    -= transaction.readLength;
 	}
+	return TWI_OK;
 }
 
 #endif
\ No newline at end of file
@@ -29,12 +29,12 @@ Function prototypes
 *********************************************/
 void    DS3231_begin         (void);
 void    DS3231_setTime       (uint8_t hour, uint8_t minute, uint8_t second);
-void    DS3231_getTime       (uint8_t* hour, uint8_t* minute, uint8_t* second);
+uint8_t DS3231_getTime       (uint8_t* hour, uint8_t* minute, uint8_t* second);
 void    DS3231_setDate       (uint8_t date, uint8_t month, uint8_t year);
-void    DS3231_getDate       (uint8_t* date, uint8_t* month, uint8_t* year);
+uint8_t DS3231_getDate       (uint8_t* date, uint8_t* month, uint8_t* year);
 void    DS3231_setDayofWeek  (uint8_t dayOfWeek);
-void    DS3231_getDayOfWeek  (uint8_t* dayOfWeek);
-void    DS3231_getTemperature(int8_t* temperature);
+uint8_t DS3231_getDayOfWeek  (uint8_t* dayOfWeek);
+uint8_t DS3231_getTemperature(int8_t* temperature);
 uint8_t DS3231_powerDown     (void);
 static uint8_t bcdToDec(uint8_t bcd);
 static uint8_t decToBcd(uint8_t dec);
@@ -57,33 +57,28 @@ Return:   None
 *********************************************/
 void DS3231_setTime(uint8_t hour, uint8_t minute, uint8_t second)
 {
-	TWI_beginTransmission(DS3231_ADDRESS); // Begin transmission to DS3231
-	TWI_write(DS3231_SECOND_REGISTER);     // Start with second register
-	TWI_write(DS3231_STOP_CLOCK_BIT);      // Set the stop clock bit
-	TWI_write(decToBcd(minute));           // Write minute
-	TWI_write(decToBcd(hour));             // Write hour
-	TWI_endTransmission();                 // End transmission to DS3231
-	TWI_beginTransmission(DS3231_ADDRESS); // Begin transmission to DS3231
-	TWI_write(DS3231_SECOND_REGISTER);     // Start with second register
-	TWI_write(decToBcd(second));           // Write second
-	TWI_endTransmission();                 // End transmission to DS3231
+	uint8_t buffer[3] = {DS3231_STOP_CLOCK_BIT, decToBcd(minute), decToBcd(hour)}; // Stop clock bit, minute, hour
+	TWI_writeRegisters(DS3231_ADDRESS, DS3231_SECOND_REGISTER, buffer, 3);         // Write starting with second register
+	buffer[0] = decToBcd(second);                                                  // Second
+	TWI_writeRegisters(DS3231_ADDRESS, DS3231_SECOND_REGISTER, buffer, 1);         // Write second and restart the clock
 }
 
 /*********************************************
 Function: getTime()
 Purpose:  Get values of hour, minute and second
 Input:    Pointers to hour, minute and second
-Return:   None
+Return:   TWI_OK or the TWI error, the values are 0 on an error
 *********************************************/
-void DS3231_getTime(uint8_t* hour, uint8_t* minute, uint8_t* second)
+uint8_t DS3231_getTime(uint8_t* hour, uint8_t* minute, uint8_t* second)
 {
-	TWI_beginTransmission(DS3231_ADDRESS);                          // Begin transmission to DS3231
-	TWI_write(DS3231_SECOND_REGISTER);                              // Start with second register
-	TWI_requestFrom(DS3231_ADDRESS, 3);                             // Request data from DS3231
-	*second = bcdToDec(TWI_read() & ~DS3231_STOP_CLOCK_BIT); // Read second
-	*minute = bcdToDec(TWI_read());                          // Read minute
-	*hour   = bcdToDec(TWI_read());                         // Read hour
-	TWI_endTransmission();                                          // End transmission to DS3231
+	uint8_t buffer[3];
+	uint8_t status = TWI_readRegisters(DS3231_ADDRESS, DS3231_SECOND_REGISTER, buffer, 3); // Read starting with second register
+	if (status != TWI_OK)
+		buffer[0] = buffer[1] = buffer[2] = 0;                            // Not read, or only partly
+	*second = bcdToDec(buffer[0] & ~DS3231_STOP_CLOCK_BIT);               // Second
+	*minute = bcdToDec(buffer[1]);                                        // Minute
+	*hour   = bcdToDec(buffer[2]);                                        // Hour
+	return status;
 }
 
 /*********************************************
@@ -94,29 +89,26 @@ Return:   None
 *********************************************/
 void DS3231_setDate(uint8_t date, uint8_t month, uint8_t year)
 {
-	TWI_beginTransmission(DS3231_ADDRESS); // Begin transmission to DS3231
-	TWI_write(DS3231_DATE_REGISTER);       // Start from date register
-	TWI_write(decToBcd(date));             // Write date
-	TWI_write(decToBcd(month));            // Write month
-	TWI_write(decToBcd(year));             // Write year
-	TWI_endTransmission();                 // End transmission to DS3231
+	const uint8_t buffer[3] = {decToBcd(date), decToBcd(month), decToBcd(year)}; // Date, month, year
+	TWI_writeRegisters(DS3231_ADDRESS, DS3231_DATE_REGISTER, buffer, 3);        // Write starting with date register
 }
 
 /*********************************************
 Function: getDate()
 Purpose:  Get values of date, month and year
 Input:    Pointers to date, month and year
-Return:   None
+Return:   TWI_OK or the TWI error, the values are 0 on an error
 *********************************************/
-void DS3231_getDate(uint8_t* date, uint8_t* month, uint8_t* year)
+uint8_t DS3231_getDate(uint8_t* date, uint8_t* month, uint8_t* year)
 {
-	TWI_beginTransmission(DS3231_ADDRESS); // Begin transmission to DS3231
-	TWI_write(DS3231_DATE_REGISTER);       // Start from date register
-	TWI_requestFrom(DS3231_ADDRESS, 3);    // Request data from DS3231
-	*date = bcdToDec(TWI_read());   // Read date
-	*month = bcdToDec(TWI_read());  // Read month
-	*year = bcdToDec(TWI_read());  // Read year
-	TWI_endTransmission();                 // End transmission to DS3231
+	uint8_t buffer[3];
+	uint8_t status = TWI_readRegisters(DS3231_ADDRESS, DS3231_DATE_REGISTER, buffer, 3); // Read starting with date register
+	if (status != TWI_OK)
+		buffer[0] = buffer[1] = buffer[2] = 0;                          // Not read, or only partly
+	*date  = bcdToDec(buffer[0]);                                       // Date
+	*month = bcdToDec(buffer[1]);                                       // Month
+	*year  = bcdToDec(buffer[2]);                                       // Year
+	return status;
 }
 
 /*********************************************
@@ -127,49 +119,50 @@ Return:   None
 *********************************************/
 void DS3231_setDayOfWeek(uint8_t dayOfWeek)
 {
-	TWI_beginTransmission(DS3231_ADDRESS); // Begin transmission to DS3231
-	TWI_write(DS3231_DAY_REGISTER);        // Start with day register
-	TWI_write(decToBcd(dayOfWeek));        // Write day of week
-	TWI_endTransmission();                 // End transmission to DS3231
+	const uint8_t buffer = decToBcd(dayOfWeek);                          // Day of week
+	TWI_writeRegisters(DS3231_ADDRESS, DS3231_DAY_REGISTER, &buffer, 1); // Write day register
 }
 
 /*********************************************
 Function: getDayOfWeek()
 Purpose:  Get value of day of week
 Input:    Pointer to day of week
-Return:   None
+Return:   TWI_OK or the TWI error, the value is 0 on an error
 *********************************************/
-void DS3231_getDayOfWeek(uint8_t* dayOfWeek)
+uint8_t DS3231_getDayOfWeek(uint8_t* dayOfWeek)
 {
-	TWI_beginTransmission(DS3231_ADDRESS);     // Begin transmission to DS3231
-	TWI_write(DS3231_DAY_REGISTER);            // Start with day register
-	TWI_requestFrom(DS3231_ADDRESS, 1);        // Request data from DS3231
-	*dayOfWeek = bcdToDec(TWI_read()); // Read day of week
-	TWI_endTransmission();                     // End transmission to DS3231
+	uint8_t status = TWI_readRegisters(DS3231_ADDRESS, DS3231_DAY_REGISTER, dayOfWeek, 1); // Read day register
+	*dayOfWeek = (status == TWI_OK) ? bcdToDec(*dayOfWeek) : 0;                            // Day of week
+	return status;
 }
 
 /*********************************************
 Function: getTemperature()
 Purpose:  Get value of internal temperature sensor
 Input:    Pointer to temperature
-Return:   None
+Return:   TWI_OK or the TWI error, the value is 0 on an error
 *********************************************/
-void DS3231_getTemperature(int8_t* temperature)
+uint8_t DS3231_getTemperature(int8_t* temperature)
 {
-	TWI_beginTransmission(DS3231_ADDRESS); // Begin transmission to DS3231
-	TWI_write(DS3231_TEMP_HIGH_REGISTER);  // Start with temperature MSB register
-	TWI_requestFrom(DS3231_ADDRESS, 1);    // Request data from DS3231
-	*temperature = TWI_read();             // Read temperature
+	uint8_t status = TWI_readRegisters(DS3231_ADDRESS, DS3231_TEMP_HIGH_REGISTER, (uint8_t*)temperature, 1); // Read temperature MSB register
+	if (status != TWI_OK)
+		*temperature = 0;
 	if (*temperature & DS3231_TEMPERATURE_SIGN_BIT) *temperature *= (int8_t)-1;
-	TWI_endTransmission();
+	return status;
 }
 
+/*********************************************
+Function: powerDown()
+Purpose:  Check if the oscillator stopped (power was lost), the time is not valid then
+Input:    None
+Return:   Non zero if power was down or the status register could not be read, 0 if not
+*********************************************/
 uint8_t DS3231_powerDown(void)
 {
-	TWI_beginTransmission(DS3231_ADDRESS);                    // Begin transmission to DS3231
-	TWI_write(DS3231_STATUS_REGISTER);                        // Start with status register
-	TWI_requestFrom(DS3231_ADDRESS, 1);                       // Request data from DS3231
-	return (TWI_read() & DS3231_OSCILLATOR_STOP_BIT); // Return 1 if power was down
+	uint8_t status = 0;
+	if (TWI_readRegisters(DS3231_ADDRESS, DS3231_STATUS_REGISTER, &status, 1) != TWI_OK) // Read status register
+		return DS3231_OSCILLATOR_STOP_BIT;                                                // Time cannot be trusted
+	return (status & DS3231_OSCILLATOR_STOP_BIT);                                         // Return 1 if power was down
 }
 
 /*********************************************
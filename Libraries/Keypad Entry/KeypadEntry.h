@@ -0,0 +1,286 @@
+#ifndef KEYPADENTRY_H
+#define KEYPADENTRY_H
+#include <string.h>
+#include "SoftTimer.h" // Timers.h first, KeypadTWI.h uses millis()
+#include "AT24C32.h"
+#include "KeypadTWI.h"
+#include "String.h"
+
+/********************************************************************************************************************
+Keypad password entry
+	- KEYPADENTRY_update() polls KEYPADTWI_getKey() and returns what happened, it never waits
+		digit: stored (up to KEYPADENTRY_LENGTH), the entry is checked as soon as it is full
+		'#':   check the entry now, '*': clear the entry, other keys are ignored
+	- Only a salted hash is stored in the AT24C32, the password itself never leaves RAM and the entry buffer
+	  is wiped after every check
+	- The hashes are compared in constant time: every byte is compared, no early exit on the first difference
+	- After KEYPADENTRY_ATTEMPTS wrong entries keys are ignored for KEYPADENTRY_LOCKOUT_MS, the lockout doubles
+	  with every further lockout (up to 16x) until a correct entry
+	- The lockout is a one-shot SoftTimer: SOFTTIMER_run() (or SCHEDULER_run()) must be called from the main loop,
+	  the display & RTC keep updating while locked
+	- The lockout state is kept in RAM, a reset clears it
+	- Until a password is stored, or when the AT24C32 cannot be read, KEYPADENTRY_DEFAULT is the password
+	- The salt comes from the time of every key press (micros()), human timing against the Timer1 clock is the
+	  entropy source, call KEYPADENTRY_setPassword() after some keys were pressed
+*********************************************************************************************************************
+AT24C32 layout at KEYPADENTRY_ADDRESS
+| OFFSET | SIZE |                 CONTENT                  |
+|   0    |  1   | KEYPADENTRY_MAGIC when a password is set |
+|   1    |  4   | Salt                                     |
+|   5    |  4   | FNV-1a hash of salt + password           |
+	- With a 4 - 8 digit keypad password anyone who can read the EEPROM can brute force any hash offline,
+	  the hash keeps the password out of plain sight, the lockout limits guessing on the keypad
+********************************************************************************************************************/
+
+#ifndef KEYPADENTRY_ADDRESS
+	#define KEYPADENTRY_ADDRESS 0x00 // First AT24C32 address used, 9 bytes
+#endif
+#ifndef KEYPADENTRY_LENGTH
+	#define KEYPADENTRY_LENGTH 6     // Digits of a password
+#endif
+#ifndef KEYPADENTRY_ATTEMPTS
+	#define KEYPADENTRY_ATTEMPTS 3   // Wrong entries before a lockout
+#endif
+#ifndef KEYPADENTRY_LOCKOUT_MS
+	#define KEYPADENTRY_LOCKOUT_MS 30000UL
+#endif
+#ifndef KEYPADENTRY_DEFAULT
+	#define KEYPADENTRY_DEFAULT "123456" // Password while none is stored
+#endif
+#define KEYPADENTRY_MAGIC 0xA5
+
+// Events returned by KEYPADENTRY_update()
+// ******************************************************************************************************************
+#define KEYPADENTRY_NONE    0 // No key
+#define KEYPADENTRY_DIGIT   1 // Digit stored, KEYPADENTRY_length() tells where
+#define KEYPADENTRY_CLEARED 2 // Entry cleared with '*'
+#define KEYPADENTRY_GRANTED 3 // Correct password
+#define KEYPADENTRY_DENIED  4 // Wrong password
+#define KEYPADENTRY_LOCKED  5 // Key ignored during a lockout
+
+/*********************************************
+Keypad entry struct
+*********************************************/
+static struct
+{
+	char            buffer[KEYPADENTRY_LENGTH + 1];
+	STRING_builder  entry;
+	uint32_t        salt, hash;
+	uint32_t        entropy;   // Mixed from the time of every key press
+	uint8_t         valid;     // A password is stored, KEYPADENTRY_DEFAULT otherwise
+	uint8_t         failures;  // Wrong entries since the last lockout or success
+	uint8_t         lockouts;  // Lockouts since the last success
+	uint8_t         locked;
+	SOFTTIMER_timer lockout;
+}_keypadEntry;
+
+/*********************************************
+Function prototypes
+*********************************************/
+void          KEYPADENTRY_begin        (void);
+uint8_t       KEYPADENTRY_setPassword  (const char* password);
+uint8_t       KEYPADENTRY_hasPassword  (void);
+uint8_t       KEYPADENTRY_update       (void);
+uint8_t       KEYPADENTRY_length       (void);
+uint8_t       KEYPADENTRY_isLocked     (void);
+unsigned long KEYPADENTRY_lockRemaining(void);
+static uint8_t  check (void);
+static uint32_t hash  (uint32_t salt, const char* password, uint8_t length);
+static void     unlock(void* context);
+
+/*********************************************
+Function: begin()
+Purpose:  Load the stored hash, call after KEYPADTWI_begin() & SOFTTIMER_begin()
+Input:    None
+Return:   None
+*********************************************/
+void KEYPADENTRY_begin(void)
+{
+	uint8_t record[9] = {0};
+
+	_keypadEntry.valid = (AT24C32_readArray(KEYPADENTRY_ADDRESS, record, sizeof(record)) == TWI_OK
+	                      && record[0] == KEYPADENTRY_MAGIC);
+	if (_keypadEntry.valid)
+	{
+		memcpy(&_keypadEntry.salt, &record[1], 4);
+		memcpy(&_keypadEntry.hash, &record[5], 4);
+	}
+	else                                                  // Nothing stored or not readable
+	{
+		_keypadEntry.salt = 0;
+		_keypadEntry.hash = hash(0, KEYPADENTRY_DEFAULT, mystrlen(KEYPADENTRY_DEFAULT));
+	}
+	_keypadEntry.entropy = micros();
+	STRING_init(&_keypadEntry.entry, _keypadEntry.buffer, sizeof(_keypadEntry.buffer));
+	_keypadEntry.lockout.callback = unlock;
+}
+
+/*********************************************
+Function: setPassword()
+Purpose:  Store the salted hash of a new password, e.g. after the default one was entered
+Input:    Password (digits)
+Return:   1 if stored, 0 if the AT24C32 did not accept it (the password is used until the next reset anyway)
+*********************************************/
+uint8_t KEYPADENTRY_setPassword(const char* password)
+{
+	uint8_t record[9], stored[9] = {0};
+
+	_keypadEntry.salt  = _keypadEntry.entropy ^ micros();
+	_keypadEntry.hash  = hash(_keypadEntry.salt, password, mystrlen(password));
+	record[0] = KEYPADENTRY_MAGIC;
+	memcpy(&record[1], &_keypadEntry.salt, 4);
+	memcpy(&record[5], &_keypadEntry.hash, 4);
+	// AT24C32_write() also returns 0 for a byte that already holds the value, the record is read back instead
+	for (uint8_t i = 0; i < sizeof(record); i++)
+		AT24C32_write(KEYPADENTRY_ADDRESS + i, record[i]);
+	_keypadEntry.valid = (AT24C32_readArray(KEYPADENTRY_ADDRESS, stored, sizeof(stored)) == TWI_OK
+	                      && !memcmp(record, stored, sizeof(record)));
+	return _keypadEntry.valid;
+}
+
+/*********************************************
+Function: hasPassword()
+Purpose:  Check if a password is stored
+Input:    None
+Return:   1 if a password is stored, 0 if KEYPADENTRY_DEFAULT is in use
+*********************************************/
+uint8_t KEYPADENTRY_hasPassword(void)
+{
+	return _keypadEntry.valid;
+}
+
+/*********************************************
+Function: update()
+Purpose:  Poll the keypad and handle one key, call it from the main loop
+Input:    None
+Return:   KEYPADENTRY_NONE, _DIGIT, _CLEARED, _GRANTED, _DENIED or _LOCKED
+*********************************************/
+uint8_t KEYPADENTRY_update(void)
+{
+	char key = KEYPADTWI_getKey();
+
+	if (!key)
+		return KEYPADENTRY_NONE;
+	_keypadEntry.entropy = (_keypadEntry.entropy ^ micros()) * 16777619UL; // Key timing, FNV-1a step
+	if (_keypadEntry.locked)
+		return KEYPADENTRY_LOCKED;
+	if (key == '*')
+	{
+		mymemset(_keypadEntry.buffer, 0, sizeof(_keypadEntry.buffer));
+		STRING_clear(&_keypadEntry.entry);
+		return KEYPADENTRY_CLEARED;
+	}
+	if (key == '#')
+		return check();
+	if (key < '0' || key > '9')
+		return KEYPADENTRY_NONE;
+	STRING_append(&_keypadEntry.entry, key);
+	if (_keypadEntry.entry.length == KEYPADENTRY_LENGTH)
+		return check();
+	return KEYPADENTRY_DIGIT;
+}
+
+/*********************************************
+Function: length()
+Purpose:  Get the number of digits entered so far
+Input:    None
+Return:   Digits
+*********************************************/
+uint8_t KEYPADENTRY_length(void)
+{
+	return _keypadEntry.entry.length;
+}
+
+/*********************************************
+Function: isLocked()
+Purpose:  Check if keys are ignored because of too many wrong entries
+Input:    None
+Return:   1 if locked, 0 if not
+*********************************************/
+uint8_t KEYPADENTRY_isLocked(void)
+{
+	return _keypadEntry.locked;
+}
+
+/*********************************************
+Function: lockRemaining()
+Purpose:  Get the time left until keys are accepted again
+Input:    None
+Return:   ms, 0 if not locked
+*********************************************/
+unsigned long KEYPADENTRY_lockRemaining(void)
+{
+	return SOFTTIMER_remaining(&_keypadEntry.lockout);
+}
+
+/*********************************************
+Function: check()
+Purpose:  Compare the entry with the stored hash, wipe it and update the lockout
+Input:    None
+Return:   KEYPADENTRY_GRANTED or KEYPADENTRY_DENIED
+*********************************************/
+static uint8_t check(void)
+{
+	uint32_t entered = hash(_keypadEntry.salt, _keypadEntry.buffer, _keypadEntry.entry.length);
+	uint8_t* a = (uint8_t*)&entered;
+	uint8_t* b = (uint8_t*)&_keypadEntry.hash;
+	uint8_t  difference = 0;
+
+	// Constant time: every byte is looked at, whatever the first difference is
+	for (uint8_t i = 0; i < sizeof(entered); i++)
+		difference |= a[i] ^ b[i];
+	mymemset(_keypadEntry.buffer, 0, sizeof(_keypadEntry.buffer));
+	STRING_clear(&_keypadEntry.entry);
+	if (!difference)
+	{
+		_keypadEntry.failures = 0;
+		_keypadEntry.lockouts = 0;
+		return KEYPADENTRY_GRANTED;
+	}
+	if (++_keypadEntry.failures >= KEYPADENTRY_ATTEMPTS)
+	{
+		_keypadEntry.failures = 0;
+		_keypadEntry.locked   = 1;
+		SOFTTIMER_start(&_keypadEntry.lockout, KEYPADENTRY_LOCKOUT_MS << _keypadEntry.lockouts, 0);
+		if (_keypadEntry.lockouts < 4)
+			_keypadEntry.lockouts++;
+	}
+	return KEYPADENTRY_DENIED;
+}
+
+/*********************************************
+Function: hash()
+Purpose:  FNV-1a over salt and password, the time depends only on the length
+Input:    Salt, password, password length
+Return:   Hash
+*********************************************/
+static uint32_t hash(uint32_t salt, const char* password, uint8_t length)
+{
+	uint32_t value = 2166136261UL;
+
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		value ^= (uint8_t)(salt >> (8 * i));
+		value *= 16777619UL;
+	}
+	for (uint8_t i = 0; i < length; i++)
+	{
+		value ^= (uint8_t)password[i];
+		value *= 16777619UL;
+	}
+	return value;
+}
+
+/*********************************************
+Function: unlock()
+Purpose:  Lockout timer callback, accept keys again
+Input:    Unused
+Return:   None
+*********************************************/
+static void unlock(void* context)
+{
+	(void)context;
+	_keypadEntry.locked = 0;
+}
+
+#endif
@@ -1,8 +1,8 @@
 #ifndef LCDTWI_H
 #define LCDTWI_H
 #include <stdarg.h>
-#include <stdio.h>
 #include "PCF8574.h"
+#include "Format.h"
 
 // LCD commands
 // ******************************************************************************************************************
@@ -72,7 +72,7 @@ void LCDTWI_home       (void);
 void LCDTWI_clear      (void);
 void LCDTWI_setCursor  (uint8_t cols, uint8_t rows);
 void LCDTWI_printf     (char* format, ...);
-static void print  (char* s);
+void LCDTWI_sink       (void* remaining, char c);
 static void command(uint8_t command);
 static void data   (char data);
 
@@ -134,30 +134,35 @@ void LCDTWI_setCursor(uint8_t cols, uint8_t rows)
 
 /*********************************************
 Function: printf()
-Purpose:  Printf a char array onto LCD
+Purpose:  Printf onto LCD, at most one line width, see Format.h for the conversions
 Input:    format, arguments
 Return:   None
 *********************************************/
 void LCDTWI_printf(char* format, ...)
 {
-	char buffer[_lcdTWI.cols + 1];
+	uint8_t _remaining = _lcdTWI.cols;
 	va_list args;
 	va_start(args, format);
-	vsnprintf(buffer, _lcdTWI.cols + 1, format, args);
+	FORMAT_vprint(LCDTWI_sink, &_remaining, format, args);
 	va_end(args);
-	print(buffer);
 }
 
 /*********************************************
-Function: print()
-Purpose:  Print a char array onto LCD
-Input:    Char array
+Function: sink()
+Purpose:  Formatter sink, print one char onto LCD
+Input:    Pointer to the amount of chars left (NULL for no limit), char
 Return:   None
 *********************************************/
-static void print(char* s)
+void LCDTWI_sink(void* remaining, char c)
 {
-	while (*s)
-		data(*s++);
+	uint8_t* _remaining = remaining;
+	if (_remaining)
+	{
+		if (!*_remaining)
+			return;
+		(*_remaining)--;
+	}
+	data(c);
 }
 
 /*********************************************
@@ -75,52 +75,57 @@
 
 void    MPU6050_begin(void);
 uint8_t MPU6050_isConnected(void);
-void    MPU6050_getAcceleration(int16_t* x, int16_t* y, int16_t* z);
-void    MPU6050_getTemperature(int16_t* t);
+uint8_t MPU6050_getAcceleration(int16_t* x, int16_t* y, int16_t* z);
+uint8_t MPU6050_getTemperature(int16_t* t);
 uint8_t MPU6050_getID(void);
 
 void MPU6050_begin(void)
 {
-	TWI_beginTransmission(MPU6050_ADDR);
-	TWI_writeData(MPU6050_PWR_MGMT_1);
-	TWI_writeData(0x00);
-	TWI_endTransmission();
+	const uint8_t wake = 0x00;
+	TWI_writeRegisters(MPU6050_ADDR, MPU6050_PWR_MGMT_1, &wake, 1);
 }
 
 uint8_t MPU6050_isConnected(void)
 {
+	if (!TWI_isPresent(MPU6050_ADDR))
+		return 0;
 	uint8_t id = MPU6050_getID();
 	return (id == MPU6050_ADDR);
 }
 
-void MPU6050_getAcceleration(int16_t* x, int16_t* y, int16_t* z)
+uint8_t MPU6050_getAcceleration(int16_t* x, int16_t* y, int16_t* z)
 {
-	TWI_beginTransmission(MPU6050_ADDR);
-	TWI_writeData(MPU6050_ACCEL_XOUT_H);
-	TWI_requestFrom(MPU6050_ADDR);
-	*x = (int16_t)(TWI_read(ACK) << 8 | TWI_read(ACK));
-	*y = (int16_t)(TWI_read(ACK) << 8 | TWI_read(ACK));
-	*z = (int16_t)(TWI_read(ACK) << 8 | TWI_read(NACK));
-	TWI_endTransmission();
+	uint8_t buffer[6];
+	uint8_t status = TWI_readRegisters(MPU6050_ADDR, MPU6050_ACCEL_XOUT_H, buffer, 6);
+	if (status != TWI_OK)
+	{
+		*x = *y = *z = 0;
+		return status;
+	}
+	*x = (int16_t)(buffer[0] << 8 | buffer[1]);
+	*y = (int16_t)(buffer[2] << 8 | buffer[3]);
+	*z = (int16_t)(buffer[4] << 8 | buffer[5]);
+	return status;
 }
 
-void MPU6050_getTemperature(int16_t* t)
+uint8_t MPU6050_getTemperature(int16_t* t)
 {
-	TWI_beginTransmission(MPU6050_ADDR);
-	TWI_writeData(MPU6050_TEMP_OUT_H);
-	TWI_requestFrom(MPU6050_ADDR);
-	*t = (int16_t)(TWI_read(ACK) << 8 | TWI_read(NACK));
+	uint8_t buffer[2];
+	uint8_t status = TWI_readRegisters(MPU6050_ADDR, MPU6050_TEMP_OUT_H, buffer, 2);
+	if (status != TWI_OK)
+	{
+		*t = 0;
+		return status;
+	}
+	*t = (int16_t)(buffer[0] << 8 | buffer[1]);
 	*t /= 340; *t += 36.53;
-	TWI_endTransmission();
+	return status;
 }
 
 uint8_t MPU6050_getID(void)
 {
-	TWI_beginTransmission(MPU6050_ADDR);
-	TWI_writeData(MPU6050_WHO_AM_I);
-	TWI_requestFrom(MPU6050_ADDR);
-	uint8_t id = TWI_read(NACK);
-	TWI_endTransmission();
+	uint8_t id = 0;
+	TWI_readRegisters(MPU6050_ADDR, MPU6050_WHO_AM_I, &id, 1);
 	return id;
 }
 
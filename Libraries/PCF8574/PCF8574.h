@@ -55,8 +55,9 @@ Return:   Data from PCF8574
 *********************************************/
 uint8_t PCF8574_read(uint8_t address)
 {
-	TWI_beginTransmission(address);
-	TWI_requestFrom(address, 1);
-	return TWI_read();
+	uint8_t data = 0;
+	TWI_transaction transaction = {.address = address, .readBuffer = &data, .readLength = 1};
+	TWI_transfer(&transaction);
+	return data;
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,239 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+#include <stdint.h>
+#if defined(__AVR__)
+#include "UART.h"
+#endif
+
+/********************************************************************************************************************
+Binary telemetry over UART
+	- Frame = COBS(type, sequence, record, CRC-16) followed by a 0x00 delimiter
+	- COBS removes every 0x00 from the frame, so a receiver resynchronizes on the next 0x00 after any error
+	- CRC-16/CCITT (reflected polynomial 0x8408, initial value 0xFFFF, same as avr-libc _crc_ccitt_update),
+	  sent low byte first, covering type, sequence and record
+	- The sequence number increments on every frame, gaps tell the receiver how many frames were lost
+	- Records are little endian and packed, exactly as they are in AVR memory
+	- Overhead is 6 bytes per record (type, sequence, 2 x CRC, COBS code, delimiter)
+	  e.g. an IMU sample is 24 bytes binary versus ~70 bytes as "%d %d %d..." text
+*********************************************************************************************************************
+Host side
+	- This header is also included by the host decoder (Tools/Telemetry Decoder), the UART part is AVR only
+	- TELEMETRY_decode() & TELEMETRY_crc() are shared by both sides
+********************************************************************************************************************/
+
+#define TELEMETRY_MAX_RECORD 32                                     // Largest record in bytes
+#define TELEMETRY_MAX_FRAME  (TELEMETRY_MAX_RECORD + 4 + 1 + 1)     // Record + header + CRC, COBS code, delimiter
+#define TELEMETRY_CRC_INIT   0xFFFF
+
+// Record types
+// ******************************************************************************************************************
+#define TELEMETRY_TIMESTAMP 0x01 // TELEMETRY_timestamp
+#define TELEMETRY_RTC       0x02 // TELEMETRY_rtc
+#define TELEMETRY_IMU       0x03 // TELEMETRY_imu
+#define TELEMETRY_VALUE     0x04 // TELEMETRY_value
+#define TELEMETRY_TEXT      0x05 // Up to TELEMETRY_MAX_RECORD chars, not null terminated
+
+/*********************************************
+Records
+*********************************************/
+typedef struct __attribute__((packed))
+{
+	uint32_t milliseconds;
+}TELEMETRY_timestamp;
+
+typedef struct __attribute__((packed))
+{
+	uint8_t second, minute, hour, dayOfWeek, day, month, year;
+	int8_t  temperature;
+}TELEMETRY_rtc;
+
+typedef struct __attribute__((packed))
+{
+	uint32_t milliseconds;
+	int16_t  accelX, accelY, accelZ;
+	int16_t  temperature;
+	int16_t  gyroX, gyroY, gyroZ;
+}TELEMETRY_imu;
+
+typedef struct __attribute__((packed))
+{
+	uint8_t channel;
+	int32_t value;
+}TELEMETRY_value;
+
+/*********************************************
+Function prototypes
+*********************************************/
+uint16_t TELEMETRY_crc   (uint16_t crc, uint8_t data);
+uint8_t  TELEMETRY_encode(const uint8_t* data, uint8_t length, uint8_t* frame);
+uint8_t  TELEMETRY_decode(const uint8_t* frame, uint8_t length, uint8_t* data);
+#if defined(__AVR__)
+void     TELEMETRY_begin  (UART_port* port);
+void     TELEMETRY_send   (uint8_t type, const void* record, uint8_t length);
+void     TELEMETRY_sendTimestamp(uint32_t milliseconds);
+void     TELEMETRY_sendRTC(const TELEMETRY_rtc* rtc);
+void     TELEMETRY_sendIMU(const TELEMETRY_imu* imu);
+void     TELEMETRY_sendValue(uint8_t channel, int32_t value);
+
+/*********************************************
+Telemetry struct
+*********************************************/
+static struct
+{
+	UART_port* port;
+	uint8_t    sequence;
+}_telemetry;
+
+/*********************************************
+Function: begin()
+Purpose:  Select the UART port used for telemetry, the port must already be initialized
+Input:    UART port
+Return:   None
+*********************************************/
+void TELEMETRY_begin(UART_port* port)
+{
+	_telemetry.port     = port;
+	_telemetry.sequence = 0;
+}
+
+/*********************************************
+Function: send()
+Purpose:  Frame a record and copy it into the UART TX ring in one block
+Input:    Record type, pointer to record, record size (at most TELEMETRY_MAX_RECORD)
+Return:   None
+*********************************************/
+void TELEMETRY_send(uint8_t type, const void* record, uint8_t length)
+{
+	uint8_t  _data[TELEMETRY_MAX_RECORD + 4];
+	uint8_t  _frame[TELEMETRY_MAX_FRAME];
+	uint16_t _crc = TELEMETRY_CRC_INIT;
+	uint8_t  _length;
+
+	if (length > TELEMETRY_MAX_RECORD)
+		length = TELEMETRY_MAX_RECORD;
+	_data[0] = type;
+	_data[1] = _telemetry.sequence++;
+	memcpy(&_data[2], record, length);
+	length += 2;
+	for (uint8_t i = 0; i < length; i++)
+		_crc = TELEMETRY_crc(_crc, _data[i]);
+	_data[length++] = (uint8_t)_crc;
+	_data[length++] = (uint8_t)(_crc >> 8);
+
+	_length = TELEMETRY_encode(_data, length, _frame);
+	_frame[_length++] = 0x00;
+	UART_write(_telemetry.port, _frame, _length);
+}
+
+/*********************************************
+Function: sendTimestamp()
+Purpose:  Send a timestamp record
+Input:    Milliseconds, e.g. millis()
+Return:   None
+*********************************************/
+void TELEMETRY_sendTimestamp(uint32_t milliseconds)
+{
+	TELEMETRY_timestamp _record = {milliseconds};
+	TELEMETRY_send(TELEMETRY_TIMESTAMP, &_record, sizeof(_record));
+}
+
+/*********************************************
+Function: sendRTC()
+Purpose:  Send a RTC reading
+Input:    Pointer to RTC record
+Return:   None
+*********************************************/
+void TELEMETRY_sendRTC(const TELEMETRY_rtc* rtc)
+{
+	TELEMETRY_send(TELEMETRY_RTC, rtc, sizeof(*rtc));
+}
+
+/*********************************************
+Function: sendIMU()
+Purpose:  Send an IMU sample
+Input:    Pointer to IMU record
+Return:   None
+*********************************************/
+void TELEMETRY_sendIMU(const TELEMETRY_imu* imu)
+{
+	TELEMETRY_send(TELEMETRY_IMU, imu, sizeof(*imu));
+}
+
+/*********************************************
+Function: sendValue()
+Purpose:  Send a generic value
+Input:    Channel number, value
+Return:   None
+*********************************************/
+void TELEMETRY_sendValue(uint8_t channel, int32_t value)
+{
+	TELEMETRY_value _record = {channel, value};
+	TELEMETRY_send(TELEMETRY_VALUE, &_record, sizeof(_record));
+}
+#endif
+
+/*********************************************
+Function: crc()
+Purpose:  Update a CRC-16/CCITT with one byte
+Input:    Current CRC, byte
+Return:   New CRC
+*********************************************/
+uint16_t TELEMETRY_crc(uint16_t crc, uint8_t data)
+{
+	data ^= (uint8_t)crc;
+	data ^= data << 4;
+	return ((((uint16_t)data << 8) | (uint8_t)(crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+/*********************************************
+Function: encode()
+Purpose:  COBS encode, the output has no 0x00 and is at most length + 1 bytes (length < 254)
+Input:    Data, data length, buffer for the frame
+Return:   Frame length (without delimiter)
+*********************************************/
+uint8_t TELEMETRY_encode(const uint8_t* data, uint8_t length, uint8_t* frame)
+{
+	uint8_t _code  = 0; // Index of the current code byte
+	uint8_t _index = 1;
+
+	for (uint8_t i = 0; i < length; i++)
+	{
+		if (data[i])
+		{
+			frame[_index++] = data[i];
+			continue;
+		}
+		// A zero closes the block, its code is the distance to the zero
+		frame[_code] = _index - _code;
+		_code = _index++;
+	}
+	frame[_code] = _index - _code;
+	return _index;
+}
+
+/*********************************************
+Function: decode()
+Purpose:  COBS decode a frame received without its delimiter
+Input:    Frame, frame length, buffer for the data (at least length bytes)
+Return:   Data length or 0 if the frame is malformed
+*********************************************/
+uint8_t TELEMETRY_decode(const uint8_t* frame, uint8_t length, uint8_t* data)
+{
+	uint8_t _index  = 0;
+	uint8_t _length = 0;
+	uint8_t _code;
+
+	while (_index < length)
+	{
+		_code = frame[_index++];
+		if (!_code || _index + _code - 1 > length)
+			return 0;
+		for (uint8_t i = 1; i < _code; i++)
+			data[_length++] = frame[_index++];
+		if (_index < length)
+			data[_length++] = 0x00; // Every block except the last one ends with a zero
+	}
+	return _length;
+}
+
+#endif
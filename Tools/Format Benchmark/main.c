@@ -0,0 +1,146 @@
+/*
+ * Format Benchmark
+ *
+ * Host side check & benchmark of Libraries/#Core/Format.h against vsnprintf
+ * Build:  gcc -O2 -static -o formatbench main.c
+ * Usage:  ./formatbench (exit code 0 when every output matches vsnprintf)
+ * Size:   nm -S --size-sort formatbench | grep -E "FORMAT_|vfprintf"
+ *         (on the AVR compare avr-size of a sketch calling UART_printf with one calling vsnprintf)
+ *
+ * Cycles are TSC cycles per call on x86, nanoseconds elsewhere. They compare the algorithms, the AVR gains more:
+ * it has no hardware divider and FORMAT_digits avoids 32 bit divisions for 16 bit values
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define UNIT "cycles"
+#else
+	#define UNIT "ns"
+#endif
+#include "../../Libraries/#Core/Format.h"
+
+#define ROUNDS 200000
+
+static struct
+{
+	char     text[64];
+	uint16_t length;
+}output;
+
+static unsigned failures, cases;
+
+uint64_t now(void);
+void     bufferSink(void* context, char c);
+int      reference(char* buffer, size_t size, const char* format, ...);
+void     report(const char* call, const char* expected, uint64_t format, uint64_t library);
+
+// Check one call against vsnprintf, then time both
+#define BENCH(...) do                                                  \
+{                                                                      \
+	char     _expected[64];                                            \
+	uint64_t _start, _format, _printf;                                 \
+	reference(_expected, sizeof _expected, __VA_ARGS__);               \
+	output.length = 0;                                                 \
+	FORMAT_print(bufferSink, &output, __VA_ARGS__);                    \
+	output.text[output.length] = '\0';                                 \
+	_start = now();                                                    \
+	for (long _i = 0; _i < ROUNDS; _i++)                               \
+	{                                                                  \
+		output.length = 0;                                             \
+		FORMAT_print(bufferSink, &output, __VA_ARGS__);                \
+	}                                                                  \
+	_format = now() - _start;                                          \
+	_start  = now();                                                   \
+	for (long _i = 0; _i < ROUNDS; _i++)                               \
+		reference(_expected, sizeof _expected, __VA_ARGS__);           \
+	_printf = now() - _start;                                          \
+	report(#__VA_ARGS__, _expected, _format, _printf);                 \
+}while (0)
+
+int main(void)
+{
+	printf("%-40s %10s %10s\n", "call", "FORMAT_" UNIT, "vsnprintf");
+	BENCH("plain text, no conversion");
+	BENCH("%d", 0);
+	BENCH("%d", -32768);
+	BENCH("%u", 65535U);
+	BENCH("%5d|%d", 42, 7);
+	BENCH("%05d", -42);
+	BENCH("%x %X %04X", 0xBEEF, 0xBEEF, 0xA);
+	BENCH("%ld", -2147483647L - 1);
+	BENCH("%lu", 4294967295UL);
+	BENCH("%lx", 0xDEADBEEFUL);
+	BENCH("%08lX", 0x1234UL);
+	BENCH("%c%c%%", 'O', 'K');
+	BENCH("%8s|%s", "abc", "");
+	BENCH("T: %3d.%02dC H: %2u%%", 23, 5, 41U);
+	BENCH("%02d:%02d:%02d %02d/%02d/20%02d", 23, 59, 7, 31, 12, 25);
+	printf("%u cases, %u mismatches\n", cases, failures);
+	return failures != 0;
+}
+
+/*********************************************
+Function: now()
+Purpose:  Read the time stamp counter (or a nanosecond clock)
+Input:    None
+Return:   Cycles
+*********************************************/
+uint64_t now(void)
+{
+	#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+	#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ULL + time.tv_nsec;
+	#endif
+}
+
+/*********************************************
+Function: bufferSink()
+Purpose:  Format.h sink writing into output
+Input:    Output, char
+Return:   None
+*********************************************/
+void bufferSink(void* context, char c)
+{
+	(void)context;
+	if (output.length < sizeof(output.text) - 1)
+		output.text[output.length++] = c;
+}
+
+/*********************************************
+Function: reference()
+Purpose:  vsnprintf behind the same variadic call as FORMAT_print()
+Input:    Buffer, size, format, arguments
+Return:   Length
+*********************************************/
+int reference(char* buffer, size_t size, const char* format, ...)
+{
+	int     length;
+	va_list args;
+	va_start(args, format);
+	length = vsnprintf(buffer, size, format, args);
+	va_end(args);
+	return length;
+}
+
+/*********************************************
+Function: report()
+Purpose:  Print the timing of one case and whether both outputs match
+Input:    Call text, vsnprintf output, total time of FORMAT_print() & vsnprintf
+Return:   None
+*********************************************/
+void report(const char* call, const char* expected, uint64_t format, uint64_t library)
+{
+	cases++;
+	printf("%-40.40s %10.1f %10.1f\n", call, (double)format / ROUNDS, (double)library / ROUNDS);
+	if (strcmp(output.text, expected))
+	{
+		failures++;
+		printf("  MISMATCH: \"%s\" expected \"%s\"\n", output.text, expected);
+	}
+}
@@ -0,0 +1,10 @@
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+#include <avr/io.h>
+
+// ISRs are plain functions, a test calls them to simulate the interrupt
+#define ISR(vector) void vector(void); void vector(void)
+#define sei() do {} while (0)
+#define cli() do {} while (0)
+
+#endif
@@ -0,0 +1,418 @@
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+#include <stdint.h>
+#include <stddef.h>
+
+/********************************************************************************************************************
+ATmega16A registers for host builds
+	- Every register is a plain variable (host_NAME), tests set inputs (TWSR, PINC, ...) and check outputs (TWCR, ...)
+	- A test can define a register itself before including a library, e.g. #define TCNT1 (*simulatedTCNT1())
+	  to run a model of the hardware on every access
+	- Single translation unit only, the variables are defined here
+********************************************************************************************************************/
+
+#if !defined(__AVR_ATmega16__) && !defined(__AVR_ATmega16A__)
+	#define __AVR_ATmega16A__
+#endif
+
+volatile uint8_t  host_TWBR;
+#ifndef TWBR
+	#define TWBR host_TWBR
+#endif
+volatile uint8_t  host_TWSR;
+#ifndef TWSR
+	#define TWSR host_TWSR
+#endif
+volatile uint8_t  host_TWAR;
+#ifndef TWAR
+	#define TWAR host_TWAR
+#endif
+volatile uint8_t  host_TWDR;
+#ifndef TWDR
+	#define TWDR host_TWDR
+#endif
+volatile uint8_t  host_TWCR;
+#ifndef TWCR
+	#define TWCR host_TWCR
+#endif
+volatile uint8_t  host_DDRA;
+#ifndef DDRA
+	#define DDRA host_DDRA
+#endif
+volatile uint8_t  host_PORTA;
+#ifndef PORTA
+	#define PORTA host_PORTA
+#endif
+volatile uint8_t  host_PINA;
+#ifndef PINA
+	#define PINA host_PINA
+#endif
+volatile uint8_t  host_DDRB;
+#ifndef DDRB
+	#define DDRB host_DDRB
+#endif
+volatile uint8_t  host_PORTB;
+#ifndef PORTB
+	#define PORTB host_PORTB
+#endif
+volatile uint8_t  host_PINB;
+#ifndef PINB
+	#define PINB host_PINB
+#endif
+volatile uint8_t  host_DDRC;
+#ifndef DDRC
+	#define DDRC host_DDRC
+#endif
+volatile uint8_t  host_PORTC;
+#ifndef PORTC
+	#define PORTC host_PORTC
+#endif
+volatile uint8_t  host_PINC;
+#ifndef PINC
+	#define PINC host_PINC
+#endif
+volatile uint8_t  host_DDRD;
+#ifndef DDRD
+	#define DDRD host_DDRD
+#endif
+volatile uint8_t  host_PORTD;
+#ifndef PORTD
+	#define PORTD host_PORTD
+#endif
+volatile uint8_t  host_PIND;
+#ifndef PIND
+	#define PIND host_PIND
+#endif
+volatile uint8_t  host_UDR;
+#ifndef UDR
+	#define UDR host_UDR
+#endif
+volatile uint8_t  host_UCSRA;
+#ifndef UCSRA
+	#define UCSRA host_UCSRA
+#endif
+volatile uint8_t  host_UCSRB;
+#ifndef UCSRB
+	#define UCSRB host_UCSRB
+#endif
+volatile uint8_t  host_UCSRC;
+#ifndef UCSRC
+	#define UCSRC host_UCSRC
+#endif
+volatile uint8_t  host_UBRRH;
+#ifndef UBRRH
+	#define UBRRH host_UBRRH
+#endif
+volatile uint8_t  host_UBRRL;
+#ifndef UBRRL
+	#define UBRRL host_UBRRL
+#endif
+volatile uint8_t  host_TCCR0;
+#ifndef TCCR0
+	#define TCCR0 host_TCCR0
+#endif
+volatile uint8_t  host_TCNT0;
+#ifndef TCNT0
+	#define TCNT0 host_TCNT0
+#endif
+volatile uint8_t  host_OCR0;
+#ifndef OCR0
+	#define OCR0 host_OCR0
+#endif
+volatile uint8_t  host_TCCR1A;
+#ifndef TCCR1A
+	#define TCCR1A host_TCCR1A
+#endif
+volatile uint8_t  host_TCCR1B;
+#ifndef TCCR1B
+	#define TCCR1B host_TCCR1B
+#endif
+volatile uint8_t  host_TIMSK;
+#ifndef TIMSK
+	#define TIMSK host_TIMSK
+#endif
+volatile uint8_t  host_TIFR;
+#ifndef TIFR
+	#define TIFR host_TIFR
+#endif
+volatile uint8_t  host_TCCR2;
+#ifndef TCCR2
+	#define TCCR2 host_TCCR2
+#endif
+volatile uint8_t  host_TCNT2;
+#ifndef TCNT2
+	#define TCNT2 host_TCNT2
+#endif
+volatile uint8_t  host_OCR2;
+#ifndef OCR2
+	#define OCR2 host_OCR2
+#endif
+volatile uint8_t  host_ASSR;
+#ifndef ASSR
+	#define ASSR host_ASSR
+#endif
+volatile uint8_t  host_ADMUX;
+#ifndef ADMUX
+	#define ADMUX host_ADMUX
+#endif
+volatile uint8_t  host_ADCSRA;
+#ifndef ADCSRA
+	#define ADCSRA host_ADCSRA
+#endif
+volatile uint8_t  host_MCUCR;
+#ifndef MCUCR
+	#define MCUCR host_MCUCR
+#endif
+volatile uint8_t  host_SREG;
+#ifndef SREG
+	#define SREG host_SREG
+#endif
+volatile uint16_t host_TCNT1;
+#ifndef TCNT1
+	#define TCNT1 host_TCNT1
+#endif
+volatile uint16_t host_OCR1A;
+#ifndef OCR1A
+	#define OCR1A host_OCR1A
+#endif
+volatile uint16_t host_OCR1B;
+#ifndef OCR1B
+	#define OCR1B host_OCR1B
+#endif
+volatile uint16_t host_ICR1;
+#ifndef ICR1
+	#define ICR1 host_ICR1
+#endif
+volatile uint16_t host_ADC;
+#ifndef ADC
+	#define ADC host_ADC
+#endif
+
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC 3
+#define TWEN 2
+#define TWIE 0
+#define TWPS1 1
+#define TWPS0 0
+#define TWGCE 0
+#define RXC 7
+#define TXC 6
+#define UDRE 5
+#define FE 4
+#define DOR 3
+#define PE 2
+#define U2X 1
+#define MPCM 0
+#define RXCIE 7
+#define TXCIE 6
+#define UDRIE 5
+#define RXEN 4
+#define TXEN 3
+#define UCSZ2 2
+#define RXB8 1
+#define TXB8 0
+#define URSEL 7
+#define UMSEL 6
+#define UPM1 5
+#define UPM0 4
+#define USBS 3
+#define UCSZ1 2
+#define UCSZ0 1
+#define UCPOL 0
+#define FOC0 7
+#define WGM00 6
+#define COM01 5
+#define COM00 4
+#define WGM01 3
+#define CS02 2
+#define CS01 1
+#define CS00 0
+#define FOC2 7
+#define WGM20 6
+#define COM21 5
+#define COM20 4
+#define WGM21 3
+#define CS22 2
+#define CS21 1
+#define CS20 0
+#define COM1A1 7
+#define COM1A0 6
+#define COM1B1 5
+#define COM1B0 4
+#define FOC1A 3
+#define FOC1B 2
+#define WGM11 1
+#define WGM10 0
+#define ICNC1 7
+#define ICES1 6
+#define WGM13 4
+#define WGM12 3
+#define CS12 2
+#define CS11 1
+#define CS10 0
+#define OCIE2 7
+#define TOIE2 6
+#define TICIE1 5
+#define OCIE1A 4
+#define OCIE1B 3
+#define TOIE1 2
+#define OCIE0 1
+#define TOIE0 0
+#define OCF2 7
+#define TOV2 6
+#define ICF1 5
+#define OCF1A 4
+#define OCF1B 3
+#define TOV1 2
+#define OCF0 1
+#define TOV0 0
+#define REFS1 7
+#define REFS0 6
+#define ADLAR 5
+#define MUX4 4
+#define MUX3 3
+#define MUX2 2
+#define MUX1 1
+#define MUX0 0
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+
+#define PORTA0 0
+#define PINA0 0
+#define DDA0 0
+#define PA0 0
+#define PORTA1 1
+#define PINA1 1
+#define DDA1 1
+#define PA1 1
+#define PORTA2 2
+#define PINA2 2
+#define DDA2 2
+#define PA2 2
+#define PORTA3 3
+#define PINA3 3
+#define DDA3 3
+#define PA3 3
+#define PORTA4 4
+#define PINA4 4
+#define DDA4 4
+#define PA4 4
+#define PORTA5 5
+#define PINA5 5
+#define DDA5 5
+#define PA5 5
+#define PORTA6 6
+#define PINA6 6
+#define DDA6 6
+#define PA6 6
+#define PORTA7 7
+#define PINA7 7
+#define DDA7 7
+#define PA7 7
+#define PORTB0 0
+#define PINB0 0
+#define DDB0 0
+#define PB0 0
+#define PORTB1 1
+#define PINB1 1
+#define DDB1 1
+#define PB1 1
+#define PORTB2 2
+#define PINB2 2
+#define DDB2 2
+#define PB2 2
+#define PORTB3 3
+#define PINB3 3
+#define DDB3 3
+#define PB3 3
+#define PORTB4 4
+#define PINB4 4
+#define DDB4 4
+#define PB4 4
+#define PORTB5 5
+#define PINB5 5
+#define DDB5 5
+#define PB5 5
+#define PORTB6 6
+#define PINB6 6
+#define DDB6 6
+#define PB6 6
+#define PORTB7 7
+#define PINB7 7
+#define DDB7 7
+#define PB7 7
+#define PORTC0 0
+#define PINC0 0
+#define DDC0 0
+#define PC0 0
+#define PORTC1 1
+#define PINC1 1
+#define DDC1 1
+#define PC1 1
+#define PORTC2 2
+#define PINC2 2
+#define DDC2 2
+#define PC2 2
+#define PORTC3 3
+#define PINC3 3
+#define DDC3 3
+#define PC3 3
+#define PORTC4 4
+#define PINC4 4
+#define DDC4 4
+#define PC4 4
+#define PORTC5 5
+#define PINC5 5
+#define DDC5 5
+#define PC5 5
+#define PORTC6 6
+#define PINC6 6
+#define DDC6 6
+#define PC6 6
+#define PORTC7 7
+#define PINC7 7
+#define DDC7 7
+#define PC7 7
+#define PORTD0 0
+#define PIND0 0
+#define DDD0 0
+#define PD0 0
+#define PORTD1 1
+#define PIND1 1
+#define DDD1 1
+#define PD1 1
+#define PORTD2 2
+#define PIND2 2
+#define DDD2 2
+#define PD2 2
+#define PORTD3 3
+#define PIND3 3
+#define DDD3 3
+#define PD3 3
+#define PORTD4 4
+#define PIND4 4
+#define DDD4 4
+#define PD4 4
+#define PORTD5 5
+#define PIND5 5
+#define DDD5 5
+#define PD5 5
+#define PORTD6 6
+#define PIND6 6
+#define DDD6 6
+#define PD6 6
+#define PORTD7 7
+#define PIND7 7
+#define DDD7 7
+#define PD7 7
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+#include <stdint.h>
+#include <string.h>
+
+// Flash is ordinary memory on the host
+#define PROGMEM
+#define PSTR(s)          (s)
+#define pgm_read_byte(a) (*(const uint8_t*)(a))
+#define memcpy_P         memcpy
+#define strlen_P         strlen
+
+#endif
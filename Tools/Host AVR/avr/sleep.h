@@ -0,0 +1,10 @@
+#ifndef HOST_AVR_SLEEP_H
+#define HOST_AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE   0
+#define set_sleep_mode(m) ((void)(m))
+#define sleep_enable()    do {} while (0)
+#define sleep_disable()   do {} while (0)
+#define sleep_cpu()       do {} while (0)
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+#include <stdint.h>
+
+// Tests are single threaded, interrupts run only where the test calls them
+// A test that models interrupt timing defines its own ATOMIC_BLOCK before including a library
+#ifndef ATOMIC_BLOCK
+	#define ATOMIC_FORCEON      0
+	#define ATOMIC_RESTORESTATE 0
+	#define ATOMIC_BLOCK(type)  for (uint8_t _atomic = 1; _atomic; _atomic = 0)
+#endif
+
+#endif
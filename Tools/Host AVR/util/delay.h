@@ -0,0 +1,14 @@
+#ifndef HOST_UTIL_DELAY_H
+#define HOST_UTIL_DELAY_H
+
+// Define HOST_DELAY as a function taking microseconds to simulate what happens while the library waits
+#if defined(HOST_DELAY)
+void HOST_DELAY(double us);
+#define _delay_us(us) HOST_DELAY(us)
+#define _delay_ms(ms) HOST_DELAY((ms) * 1000.0)
+#else
+static inline void _delay_us(double us) { (void)us; }
+static inline void _delay_ms(double ms) { (void)ms; }
+#endif
+
+#endif
@@ -0,0 +1,313 @@
+/*
+ * String Test
+ *
+ * Host side unit tests of Libraries/#Core/String.h and a benchmark of STRING_builder against the old pattern,
+ * mystrcat() rescanning the destination with mystrlen() before every append
+ * Build:  gcc -O2 -o stringtest main.c
+ * Usage:  ./stringtest (exit code 0 when every check passes)
+ *
+ * Cycles are TSC cycles per call on x86, nanoseconds elsewhere. The rescan costs O(length) per append on any
+ * target, the AVR pays it at 1 - 2 cycles per byte
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define UNIT "cycles"
+#else
+	#define UNIT "ns"
+#endif
+#include "../../Libraries/#Core/String.h"
+
+#define ROUNDS 200000
+
+static struct
+{
+	char     text[64];
+	uint8_t  length;
+	unsigned failures, checks;
+}test;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+void     check(int condition, const char* text, int line);
+uint64_t now(void);
+void     bufferSink(void* context, char c);
+char*    oldStrcat(char* destination, const char* source, size_t size);
+void     oldKeys(char* buffer, uint8_t count);
+void     newKeys(STRING_builder* builder, uint8_t count);
+void     oldLine(char* buffer);
+void     newLine(STRING_builder* builder);
+void     report(const char* name, uint64_t old, uint64_t builder);
+
+int main(void)
+{
+	char           small[4], line[21], old[21], message[251], oldMessage[251];
+	STRING_builder builder = STRING_BUILDER(small);
+	STRING_builder text    = STRING_BUILDER(line);
+	STRING_builder frame   = STRING_BUILDER(message);
+	uint64_t       start, oldTime, newTime;
+
+	// Builder: the initializer keeps the size (a buffer over 255 bytes does not compile)
+	CHECK(frame.size == sizeof message && text.size == sizeof line && frame.length == 0);
+
+	// Builder: empty, terminated and never written past its size
+	memset(small, 'x', sizeof small);
+	STRING_init(&builder, small, sizeof small);
+	CHECK(builder.length == 0 && small[0] == '\0' && !builder.overflow);
+	STRING_append(&builder, 'a');
+	STRING_append(&builder, 'b');
+	STRING_append(&builder, 'c');
+	CHECK(builder.length == 3 && !strcmp(small, "abc") && !builder.overflow);
+	STRING_append(&builder, 'd');
+	CHECK(builder.length == 3 && !strcmp(small, "abc") && builder.overflow);
+	STRING_clear(&builder);
+	CHECK(builder.length == 0 && small[0] == '\0' && !builder.overflow);
+	STRING_appendText(&builder, "hello");
+	CHECK(!strcmp(small, "hel") && builder.overflow);
+
+	// Numbers
+	STRING_clear(&text);
+	STRING_appendDecimal(&text, 0);
+	STRING_append(&text, ' ');
+	STRING_appendDecimal(&text, -32768);
+	STRING_append(&text, ' ');
+	STRING_appendDecimal(&text, -2147483647L - 1);
+	CHECK(!strcmp(line, "0 -32768 -2147483648"));
+	STRING_clear(&text);
+	STRING_appendHex(&text, 0xBEEF, 0);
+	STRING_append(&text, ' ');
+	STRING_appendHex(&text, 0xA, 4);
+	STRING_append(&text, ' ');
+	STRING_appendHex(&text, 0xDEADBEEFUL, 2);
+	CHECK(!strcmp(line, "BEEF 000A DEADBEEF"));
+	STRING_clear(&text);
+	STRING_appendPadded(&text, 42, 5, ' ');
+	STRING_appendPadded(&text, -42, 5, ' ');
+	STRING_appendPadded(&text, -42, 5, '0');
+	STRING_appendPadded(&text, 12345, 2, '0');
+	CHECK(!strcmp(line, "   42  -42-004212345"));
+	CHECK(text.length == 20 && !text.overflow);
+	STRING_appendDecimal(&text, 7);
+	CHECK(text.length == 20 && text.overflow && line[20] == '\0');
+
+	// printf & flush
+	STRING_clear(&text);
+	STRING_printf(&text, "T: %3d.%02dC", 23, 5);
+	CHECK(!strcmp(line, "T:  23.05C") && text.length == 10);
+	test.length = 0;
+	CHECK(STRING_flush(&text, bufferSink, NULL) == 10);
+	test.text[test.length] = '\0';
+	CHECK(!strcmp(test.text, "T:  23.05C"));
+	CHECK(text.length == 0 && line[0] == '\0');
+
+	// Bounded routines
+	strcpy(small, "ab");
+	CHECK(mystrlcat(small, "cd", sizeof small) == 4 && !strcmp(small, "abc"));
+	memcpy(small, "abcd", 4);                          // Not terminated: nothing is written
+	CHECK(mystrlcat(small, "e", sizeof small) == 5 && !memcmp(small, "abcd", 4));
+	small[0] = '\0';
+	CHECK(mystrappend(small, 0, "12", 2, sizeof small) == 2 && !strcmp(small, "12"));
+	CHECK(mystrappend(small, 2, "34", 2, sizeof small) == 4 && !strcmp(small, "123"));
+	CHECK(mystrappend(small, 4, "5", 1, sizeof small) == 5 && !strcmp(small, "123"));
+	CHECK(mystrlen("") == 0 && mystrlen("keypad") == 6);
+	memset(small, 'x', sizeof small);
+	CHECK(mymemset(small, 0, sizeof small) == small && !memcmp(small, "\0\0\0\0", 4));
+	CHECK(mystrncmp("abc", "abd", 2) == 0 && mystrncmp("abc", "abd", 3) < 0);
+	CHECK(mystrncmp("abc", "abc", 10) == 0 && mystrncmp("ab", "abc", 10) < 0);
+	CHECK(mystrncmp("\xFF", "a", 1) > 0);
+
+	// Both patterns build the same text
+	oldKeys(old, 20);
+	newKeys(&text, 20);
+	CHECK(!strcmp(old, line));
+	oldKeys(oldMessage, 250);
+	newKeys(&frame, 250);
+	CHECK(!strcmp(oldMessage, message) && !frame.overflow);
+	oldLine(old);
+	newLine(&text);
+	CHECK(!strcmp(old, line) && !strcmp(line, "12:34:56 31/12/2025"));
+
+	// Benchmark
+	printf("%-40s %10s %10s\n", "case (" UNIT " per call)", "mystrcat", "builder");
+	start   = now();
+	for (long i = 0; i < ROUNDS; i++)
+		oldKeys(old, 20);
+	oldTime = now() - start;
+	start   = now();
+	for (long i = 0; i < ROUNDS; i++)
+		newKeys(&text, 20);
+	newTime = now() - start;
+	report("LCD line, 20 chars one by one", oldTime, newTime);
+	start   = now();
+	for (long i = 0; i < ROUNDS; i++)
+		oldKeys(oldMessage, 250);
+	oldTime = now() - start;
+	start   = now();
+	for (long i = 0; i < ROUNDS; i++)
+		newKeys(&frame, 250);
+	newTime = now() - start;
+	report("UART message, 250 chars one by one", oldTime, newTime);
+	start   = now();
+	for (long i = 0; i < ROUNDS; i++)
+		oldLine(old);
+	oldTime = now() - start;
+	start   = now();
+	for (long i = 0; i < ROUNDS; i++)
+		newLine(&text);
+	newTime = now() - start;
+	report("clock line, 6 numbers & separators", oldTime, newTime);
+
+	printf("%u checks, %u failed\n", test.checks, test.failures);
+	return test.failures != 0;
+}
+
+/*********************************************
+Function: check()
+Purpose:  Count a check and report it when it fails
+Input:    Result, source text, line
+Return:   None
+*********************************************/
+void check(int condition, const char* text, int line)
+{
+	test.checks++;
+	if (!condition)
+	{
+		test.failures++;
+		printf("FAIL line %d: %s\n", line, text);
+	}
+}
+
+/*********************************************
+Function: now()
+Purpose:  Read the time stamp counter (or a nanosecond clock)
+Input:    None
+Return:   Cycles
+*********************************************/
+uint64_t now(void)
+{
+	#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+	#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ULL + time.tv_nsec;
+	#endif
+}
+
+/*********************************************
+Function: bufferSink()
+Purpose:  Format.h sink writing into test.text
+Input:    Unused, char
+Return:   None
+*********************************************/
+void bufferSink(void* context, char c)
+{
+	(void)context;
+	if (test.length < sizeof(test.text) - 1)
+		test.text[test.length++] = c;
+}
+
+/*********************************************
+Function: oldStrcat()
+Purpose:  The mystrcat() String.h had before the builder: find the end, copy size chars, no bound
+Input:    Destination, source, amount of chars
+Return:   Destination
+*********************************************/
+char* oldStrcat(char* destination, const char* source, size_t size)
+{
+	char* pointer = destination + mystrlen(destination);
+	while (size--)
+		*pointer++ = *source++;
+	*pointer = '\0';
+	return destination;
+}
+
+/*********************************************
+Function: oldKeys()
+Purpose:  Keypad style entry with mystrcat, one key at a time
+Input:    Buffer of count + 1 chars, count
+Return:   None
+*********************************************/
+void oldKeys(char* buffer, uint8_t count)
+{
+	buffer[0] = '\0';
+	for (uint8_t i = 0; i < count; i++)
+	{
+		char key = '0' + i % 10;
+		oldStrcat(buffer, &key, 1);
+	}
+}
+
+/*********************************************
+Function: newKeys()
+Purpose:  Keypad style entry with the builder, one key at a time
+Input:    Builder of count + 1 chars, count
+Return:   None
+*********************************************/
+void newKeys(STRING_builder* builder, uint8_t count)
+{
+	STRING_clear(builder);
+	for (uint8_t i = 0; i < count; i++)
+		STRING_append(builder, '0' + i % 10);
+}
+
+/*********************************************
+Function: oldLine()
+Purpose:  Clock line with mystrcat, every number converted to a temporary first
+Input:    Buffer of 21 chars
+Return:   None
+*********************************************/
+void oldLine(char* buffer)
+{
+	static const long values[6]     = {12, 34, 56, 31, 12, 2025};
+	static const char separators[6] = ":: //";
+	char              digits[10], number[10];
+	uint8_t           length;
+
+	buffer[0] = '\0';
+	for (uint8_t i = 0; i < 6; i++)
+	{
+		length = FORMAT_digits(digits, values[i], 10, 0);
+		if (length < 2)
+			digits[length++] = '0';
+		for (uint8_t j = 0; j < length; j++)
+			number[j] = digits[length - 1 - j];
+		oldStrcat(buffer, number, length);
+		if (separators[i])
+			oldStrcat(buffer, &separators[i], 1);
+	}
+}
+
+/*********************************************
+Function: newLine()
+Purpose:  Clock line with the builder
+Input:    Builder of 21 chars
+Return:   None
+*********************************************/
+void newLine(STRING_builder* builder)
+{
+	static const long values[6]     = {12, 34, 56, 31, 12, 2025};
+	static const char separators[6] = ":: //";
+
+	STRING_clear(builder);
+	for (uint8_t i = 0; i < 6; i++)
+	{
+		STRING_appendPadded(builder, values[i], 2, '0');
+		if (separators[i])
+			STRING_append(builder, separators[i]);
+	}
+}
+
+/*********************************************
+Function: report()
+Purpose:  Print the time per call of one case
+Input:    Case, total time of the mystrcat & the builder pattern
+Return:   None
+*********************************************/
+void report(const char* name, uint64_t old, uint64_t builder)
+{
+	printf("%-40.40s %10.1f %10.1f\n", name, (double)old / ROUNDS, (double)builder / ROUNDS);
+}
@@ -0,0 +1,328 @@
+/*
+ * TWI Test
+ *
+ * Host side simulation & fault injection for Libraries/#Core/TWI.h, the bus is simulated by feeding TWSR codes
+ * to TWI_vect
+ * Build:  gcc -O2 -I"../Host AVR" -o twitest main.c
+ * Usage:  ./twitest (exit code 0 when every check passes)
+ */
+
+#define F_CPU      16000000UL
+#define HOST_DELAY hostDelay
+
+#include <stdio.h>
+#include "../../Libraries/#Core/TWI.h"
+
+static struct
+{
+	double   elapsed;           // Microseconds waited by the library
+	void     (*bus)(void);      // Other bus activity, runs on every wait
+	uint8_t  sdaDriven, clocks; // Bus clear: SDA pulled low, SCL pulses
+	unsigned failures, checks;
+}test;
+
+static uint8_t completed;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+void    check(int condition, const char* text, int line);
+uint8_t interrupt(uint8_t status);
+void    reset(uint32_t frequency);
+void    done(TWI_transaction* transaction);
+void    hostDelay(double us);
+void    winner(void);
+
+int main(void)
+{
+	uint8_t data[2] = {0x12, 0x34};
+	TWI_transaction a = {.address = 0x50, .writeBuffer = data, .writeLength = 2, .callback = done};
+	TWI_transaction b = {.address = 0x51, .writeBuffer = data, .writeLength = 1, .callback = done};
+	uint8_t received[2], reg = 0x3B;
+	TWI_transaction c = {.address = 0x52, .writeBuffer = &reg, .writeLength = 1,
+	                     .readBuffer = received, .readLength = 2, .callback = done};
+	uint8_t control;
+
+	// Queue: transactions run in submission order, a STOP & START separate them, every one calls back
+	reset(F_TWI_100K);
+	completed = 0;
+	CHECK(TWI_submit(&a) && TWI_submit(&b));
+	CHECK(TWCR & (1 << TWSTA));
+	interrupt(TW_START);
+	CHECK(TWDR == (0x50 << 1));
+	interrupt(TW_MT_SLA_ACK);
+	CHECK(TWDR == 0x12);
+	interrupt(TW_MT_DATA_ACK);
+	CHECK(TWDR == 0x34);
+	control = interrupt(TW_MT_DATA_ACK);
+	CHECK(a.status == TWI_OK && b.status == TWI_PENDING && completed == 1);
+	CHECK((control & ((1 << TWSTO) | (1 << TWSTA))) == ((1 << TWSTO) | (1 << TWSTA)));
+	interrupt(TW_START);
+	CHECK(TWDR == (0x51 << 1));
+	interrupt(TW_MT_SLA_ACK);
+	control = interrupt(TW_MT_DATA_ACK);
+	CHECK(b.status == TWI_OK && completed == 2);
+	CHECK((control & ((1 << TWSTO) | (1 << TWSTA))) == (1 << TWSTO));
+	CHECK(_twi.head == _twi.tail && !_twi.busy);
+
+	// Busy time from the SCL clocks of a completed transaction
+	CHECK(a.clocks > b.clocks && b.clocks >= 18);
+	CHECK(TWI_busyTime(&a) == a.clocks * 10UL);
+
+	// Register read: write phase, repeated START, the last byte is NACKed
+	reset(F_TWI_100K);
+	completed = 0;
+	TWI_submit(&c);
+	interrupt(TW_START);
+	interrupt(TW_MT_SLA_ACK);
+	control = interrupt(TW_MT_DATA_ACK);
+	CHECK((control & ((1 << TWSTO) | (1 << TWSTA))) == (1 << TWSTA));
+	interrupt(TW_REP_START);
+	CHECK(TWDR == ((0x52 << 1) | 1));
+	control = interrupt(TW_MR_SLA_ACK);
+	CHECK(control & (1 << TWEA));
+	TWDR = 0xAB;
+	control = interrupt(TW_MR_DATA_ACK);
+	CHECK(!(control & (1 << TWEA)));
+	TWDR = 0xCD;
+	control = interrupt(TW_MR_DATA_NACK);
+	CHECK(c.status == TWI_OK && completed == 1 && received[0] == 0xAB && received[1] == 0xCD);
+	CHECK(control & (1 << TWSTO));
+
+	// Wrapper: a write past TWI_BUFFER_SIZE fails and nothing is sent, a truncated write would corrupt the slave
+	reset(F_TWI_100K);
+	TWI_beginTransmission(0x50);
+	for (uint8_t i = 0; i < TWI_BUFFER_SIZE; i++)
+		CHECK(TWI_write(i));
+	CHECK(!TWI_write(0xFF));
+	CHECK(TWI_endTransmission() == TWI_ERROR_OVERFLOW);
+	CHECK(!(TWCR & (1 << TWSTA)) && _twi.head == _twi.tail && !_twi.busy);
+
+	// Bus error while idle: no slot to complete, the error is cleared with TWSTO & TWINT
+	reset(F_TWI_100K);
+	control = interrupt(TW_BUS_ERROR);
+	CHECK(_twi.statistics.bus == 1);
+	CHECK(_twi.statistics.transactions == 0);
+	CHECK((control & ((1 << TWSTO) | (1 << TWINT))) == ((1 << TWSTO) | (1 << TWINT)));
+	CHECK(_twi.head == _twi.tail && !_twi.busy);
+
+	// Stray START while idle: the empty slot is not dereferenced
+	control = interrupt(TW_START);
+	CHECK(_twi.statistics.bus == 2);
+	CHECK(control & (1 << TWSTO));
+	CHECK(_twi.head == _twi.tail && !_twi.busy);
+
+	// Bus error after a completed transaction: the stale slot is not completed twice
+	reset(F_TWI_100K);
+	completed = 0;
+	TWI_submit(&a);
+	interrupt(TW_START);
+	interrupt(TW_MT_SLA_ACK);
+	interrupt(TW_MT_DATA_ACK);
+	control = interrupt(TW_MT_DATA_ACK);
+	CHECK(a.status == TWI_OK && completed == 1);
+	CHECK(control & (1 << TWSTO));
+	interrupt(TW_BUS_ERROR);
+	CHECK(a.status == TWI_OK && completed == 1);
+	CHECK(_twi.statistics.transactions == 1 && _twi.statistics.bus == 1);
+	CHECK(_twi.head == _twi.tail && !_twi.busy);
+
+	// Bus error in the middle of a transaction: it fails, the next queued one starts
+	reset(F_TWI_100K);
+	completed = 0;
+	TWI_submit(&a);
+	TWI_submit(&b);
+	interrupt(TW_START);
+	interrupt(TW_MT_SLA_ACK);
+	control = interrupt(TW_BUS_ERROR);
+	CHECK(a.status == TWI_ERROR_BUS && b.status == TWI_PENDING);
+	CHECK(control & (1 << TWSTA));
+	interrupt(TW_START);
+	interrupt(TW_MT_SLA_ACK);
+	interrupt(TW_MT_DATA_ACK);
+	CHECK(b.status == TWI_OK && completed == 2);
+	CHECK(_twi.statistics.bus == 1 && !_twi.busy);
+
+	// Address not acknowledged
+	reset(F_TWI_100K);
+	TWI_submit(&a);
+	interrupt(TW_START);
+	control = interrupt(TW_MT_SLA_NACK);
+	CHECK(a.status == TWI_ERROR_NACK && _twi.statistics.nack == 1);
+	CHECK(control & (1 << TWSTO));
+
+	// Lost arbitration: restarted TWI_ARBITRATION_RETRIES times, then failed without a STOP
+	reset(F_TWI_100K);
+	TWI_submit(&a);
+	interrupt(TW_START);
+	for (uint8_t i = 0; i < TWI_ARBITRATION_RETRIES; i++)
+		CHECK(interrupt(TW_MT_ARB_LOST) & (1 << TWSTA));
+	control = interrupt(TW_MT_ARB_LOST);
+	CHECK(a.status == TWI_ERROR_ARBITRATION && a.retries == TWI_ARBITRATION_RETRIES);
+	CHECK(!(control & (1 << TWSTO)));
+	CHECK(_twi.statistics.arbitration == TWI_ARBITRATION_RETRIES + 1);
+
+	// No bus activity: the blocking call gives up after the timeout and clears the bus
+	reset(F_TWI_100K);
+	CHECK(TWI_transfer(&a) == TWI_ERROR_TIMEOUT);
+	CHECK(_twi.statistics.timeout == 1);
+	CHECK(test.elapsed >= _twi.timeout && test.elapsed < _twi.timeout + 100);
+
+	// Bus clear with SDA free: no clocks and no forced STOP
+	CHECK(_twi.statistics.recovery == 0 && !test.sdaDriven && !test.clocks);
+
+	// Bus clear with SDA held low by a slave: 9 clocks and a STOP
+	reset(F_TWI_100K);
+	PINC &= ~(1 << PORTC1);
+	TWI_recover();
+	CHECK(_twi.statistics.recovery == 1 && test.sdaDriven && test.clocks == 9);
+	PINC |= (1 << PORTC1);
+
+	// Lost arbitration to a master with a transfer longer than the timeout: no timeout while the START waits
+	reset(F_TWI_100K);
+	test.bus = winner;
+	CHECK(TWI_transfer(&a) == TWI_OK);
+	CHECK(_twi.statistics.timeout == 0 && _twi.statistics.retry == 1);
+	CHECK(test.elapsed > 3 * _twi.timeout);
+	test.bus = 0;
+
+	// Slow SCL: the timeout no longer fits 16 bits and must not wrap
+	reset(1000);
+	CHECK(TWI_getFrequency() <= 1000 && TWI_getFrequency() > 900);
+	CHECK(_twi.timeout == (9000000UL / _twi.frequency + 1) * TWI_TIMEOUT_BYTES);
+	CHECK(_twi.timeout > 65535);
+	CHECK(TWI_transfer(&a) == TWI_ERROR_TIMEOUT);
+	CHECK(test.elapsed >= _twi.timeout);
+
+	// Busy time: 100 clocks at 100 kHz, and no division by zero before TWI_begin() or below 100 Hz
+	{
+		TWI_transaction timed = {.clocks = 100};
+		uint32_t        frequency = _twi.frequency;
+		_twi.frequency = 100000UL;
+		CHECK(TWI_busyTime(&timed) == 1000);
+		_twi.frequency = 0;
+		CHECK(TWI_busyTime(&timed) == 0);
+		_twi.frequency = 50;
+		CHECK(TWI_busyTime(&timed) == 2000000UL);
+		_twi.frequency = frequency;
+	}
+
+	// Blocks larger than the wrapper buffers are rejected, not truncated, and the bus is not touched
+	reset(F_TWI_100K);
+	{
+		uint8_t block[TWI_BUFFER_SIZE] = {0};
+		CHECK(TWI_writeRegisters(0x50, 0x00, block, TWI_BUFFER_SIZE) == TWI_ERROR_OVERFLOW);
+		CHECK(TWI_requestFrom(0x50, TWI_BUFFER_SIZE + 1) == TWI_ERROR_OVERFLOW);
+		CHECK(!(TWCR & (1 << TWSTA)) && _twi.head == _twi.tail && !_twi.busy);
+	}
+
+	printf("%u checks, %u failed\n", test.checks, test.failures);
+	return test.failures != 0;
+}
+
+/*********************************************
+Function: check()
+Purpose:  Count a check and report it when it fails
+Input:    Result, source text, line
+Return:   None
+*********************************************/
+void check(int condition, const char* text, int line)
+{
+	test.checks++;
+	if (!condition)
+	{
+		test.failures++;
+		printf("FAIL line %d: %s\n", line, text);
+	}
+}
+
+/*********************************************
+Function: interrupt()
+Purpose:  Simulate a bus event, the hardware clears TWINT when it is written
+Input:    TWSR status
+Return:   TWCR written by the ISR
+*********************************************/
+uint8_t interrupt(uint8_t status)
+{
+	uint8_t control;
+
+	TWSR = status;
+	TWCR |= (1 << TWINT);
+	TWI_vect();
+	control = TWCR;
+	TWCR &= ~(1 << TWINT);
+	return control;
+}
+
+/*********************************************
+Function: reset()
+Purpose:  Start every case from an idle bus with SDA & SCL high
+Input:    SCL frequency in Hz
+Return:   None
+*********************************************/
+void reset(uint32_t frequency)
+{
+	PINC = (1 << PORTC0) | (1 << PORTC1);
+	TWCR = 0;
+	TWI_begin(frequency);
+	TWI_clearStatistics();
+	test.elapsed   = 0;
+	test.sdaDriven = 0;
+	test.clocks    = 0;
+}
+
+/*********************************************
+Function: done()
+Purpose:  Transaction callback
+Input:    Transaction
+Return:   None
+*********************************************/
+void done(TWI_transaction* transaction)
+{
+	(void)transaction;
+	completed++;
+}
+
+/*********************************************
+Function: hostDelay()
+Purpose:  _delay_us()/_delay_ms() of the library, time only passes here
+Input:    Microseconds
+Return:   None
+*********************************************/
+void hostDelay(double us)
+{
+	if (DDRC & (1 << PORTC1))
+		test.sdaDriven = 1;
+	if ((DDRC & (1 << PORTC0)) && !(DDRC & (1 << PORTC1)))
+		test.clocks++;
+	test.elapsed += us;
+	if (test.bus)
+		test.bus();
+}
+
+/*********************************************
+Function: winner()
+Purpose:  Another master wins arbitration on the first byte and keeps the bus for 3 timeouts
+Input:    None
+Return:   None
+*********************************************/
+void winner(void)
+{
+	static uint8_t state;
+
+	if (test.elapsed <= 1)
+		state = 0;
+	if (state == 0)
+	{
+		interrupt(TW_START);
+		interrupt(TW_MT_ARB_LOST);
+		state = 1;
+	}
+	else if (state == 1 && test.elapsed > 3 * _twi.timeout)
+	{
+		interrupt(TW_START);                      // Winner's STOP, the held back START goes out
+		interrupt(TW_MT_SLA_ACK);
+		interrupt(TW_MT_DATA_ACK);
+		interrupt(TW_MT_DATA_ACK);
+		state = 2;
+	}
+}
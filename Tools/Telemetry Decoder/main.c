@@ -0,0 +1,144 @@
+/*
+ * Telemetry Decoder
+ *
+ * Host side decoder for Libraries/Telemetry frames
+ * Build:  gcc -O2 -o decoder main.c
+ * Usage:  stty -F /dev/ttyUSB0 115200 raw -echo && ./decoder /dev/ttyUSB0
+ *         ./decoder capture.bin
+ *         ./decoder < capture.bin
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../../Libraries/Telemetry/Telemetry.h"
+
+static struct
+{
+	unsigned long frames, crc, malformed, oversized, lost;
+	uint8_t       sequence, synced;
+}decoder;
+
+void printRecord(const uint8_t* data, uint8_t length);
+void handleFrame(const uint8_t* frame, uint8_t length);
+
+int main(int argc, char** argv)
+{
+	FILE*   input = stdin;
+	uint8_t frame[TELEMETRY_MAX_FRAME];
+	uint8_t length = 0, overflow = 0;
+	int     c;
+
+	if (argc > 1 && !(input = fopen(argv[1], "rb")))
+	{
+		perror(argv[1]);
+		return 1;
+	}
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	while ((c = fgetc(input)) != EOF)
+	{
+		if (c)
+		{
+			if (length < sizeof(frame))
+				frame[length++] = (uint8_t)c;
+			else
+				overflow = 1;
+			continue;
+		}
+		// Delimiter, the bytes since the previous one are a frame
+		if (overflow)
+			decoder.oversized++;
+		else if (length)
+			handleFrame(frame, length);
+		length = 0; overflow = 0;
+	}
+	fprintf(stderr, "frames %lu, crc errors %lu, malformed %lu, oversized %lu, lost %lu\n",
+	        decoder.frames, decoder.crc, decoder.malformed, decoder.oversized, decoder.lost);
+	return 0;
+}
+
+/*********************************************
+Function: handleFrame()
+Purpose:  Decode a frame, check its CRC and sequence number
+Input:    Frame without delimiter, frame length
+Return:   None
+*********************************************/
+void handleFrame(const uint8_t* frame, uint8_t length)
+{
+	uint8_t  data[TELEMETRY_MAX_FRAME];
+	uint16_t crc = TELEMETRY_CRC_INIT;
+	uint8_t  size = TELEMETRY_decode(frame, length, data);
+
+	if (size < 4)
+	{
+		decoder.malformed++;
+		return;
+	}
+	for (uint8_t i = 0; i < size - 2; i++)
+		crc = TELEMETRY_crc(crc, data[i]);
+	if (crc != (uint16_t)(data[size - 2] | (data[size - 1] << 8)))
+	{
+		decoder.crc++;
+		return;
+	}
+	decoder.frames++;
+	if (decoder.synced && data[1] != decoder.sequence)
+		decoder.lost += (uint8_t)(data[1] - decoder.sequence);
+	decoder.sequence = data[1] + 1;
+	decoder.synced   = 1;
+	printRecord(data, size - 2);
+}
+
+/*********************************************
+Function: printRecord()
+Purpose:  Print one record as a text line
+Input:    Type, sequence and record, their length
+Return:   None
+*********************************************/
+void printRecord(const uint8_t* data, uint8_t length)
+{
+	const uint8_t* record = data + 2;
+	uint8_t        size   = length - 2;
+
+	printf("%3u ", data[1]);
+	switch (data[0])
+	{
+		case TELEMETRY_TIMESTAMP:
+		{
+			TELEMETRY_timestamp r;
+			if (size != sizeof(r)) break;
+			memcpy(&r, record, sizeof(r));
+			printf("timestamp %lu ms\n", (unsigned long)r.milliseconds);
+			return;
+		}
+		case TELEMETRY_RTC:
+		{
+			TELEMETRY_rtc r;
+			if (size != sizeof(r)) break;
+			memcpy(&r, record, sizeof(r));
+			printf("rtc %02u:%02u:%02u %02u/%02u/%02u dow %u %d C\n",
+			       r.hour, r.minute, r.second, r.day, r.month, r.year, r.dayOfWeek, r.temperature);
+			return;
+		}
+		case TELEMETRY_IMU:
+		{
+			TELEMETRY_imu r;
+			if (size != sizeof(r)) break;
+			memcpy(&r, record, sizeof(r));
+			printf("imu %lu ms accel %d %d %d gyro %d %d %d temp %d\n", (unsigned long)r.milliseconds,
+			       r.accelX, r.accelY, r.accelZ, r.gyroX, r.gyroY, r.gyroZ, r.temperature);
+			return;
+		}
+		case TELEMETRY_VALUE:
+		{
+			TELEMETRY_value r;
+			if (size != sizeof(r)) break;
+			memcpy(&r, record, sizeof(r));
+			printf("value %u = %ld\n", r.channel, (long)r.value);
+			return;
+		}
+		case TELEMETRY_TEXT:
+			printf("text %.*s\n", size, (const char*)record);
+			return;
+	}
+	printf("type 0x%02X, %u bytes\n", data[0], size);
+}
@@ -0,0 +1,312 @@
+/*
+ * Timers Test
+ *
+ * Host side test of TIMER1_begin(), micros() & TIMER1_toMicros() in Libraries/#Core/Timers.h against a cycle model
+ * of Timer1
+ * Build:  gcc -O2 -I"../Host AVR" -o timerstest main.c
+ *         other clocks & ticks with e.g. -DF_CPU=12288000UL or -DF_CPU=8000000UL -DTIMER1_TICK_US=250UL
+ * Usage:  ./timerstest (exit code 0 when every check passes)
+ *
+ * Model
+ *	- Every access to a Timer1 register costs 8 CPU cycles (1 - 16 with jitter), the timer runs from a free running
+ *	  prescaler
+ *	- Fast PWM mode 15: the compare match with TOP (OCR1A) sets OCF1A at the next timer clock, when TCNT1 restarts
+ *	  from 0 and the buffered OCR1A is loaded, other modes write OCR1A directly
+ *	- The compare ISR runs as soon as OCF1A is set, OCIE1A is enabled and interrupts are not blocked
+ *	- Interrupts are blocked inside ATOMIC_BLOCK and in windows the test opens to delay the ISR
+ */
+
+#ifndef F_CPU
+	#define F_CPU 16000000UL
+#endif
+#ifndef TIMER1_TICK_US
+	#define TIMER1_TICK_US 5000UL // Prescaler 8 at 16 MHz: TCNT1 stays at TOP for 8 cycles before OCF1A is set
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// Timer1 registers are routed through the model, a write is seen at the next access
+enum {SIM_TCNT1, SIM_OCR1A, SIM_TIFR, SIM_TCCR1A, SIM_TCCR1B, SIM_REGISTERS};
+volatile uint32_t* simRegister(uint8_t id);
+uint8_t            simAtomic(uint8_t enter, uint8_t force);
+#define TCNT1  (*simRegister(SIM_TCNT1))
+#define OCR1A  (*simRegister(SIM_OCR1A))
+#define TIFR   (*simRegister(SIM_TIFR))
+#define TCCR1A (*simRegister(SIM_TCCR1A))
+#define TCCR1B (*simRegister(SIM_TCCR1B))
+#define ATOMIC_FORCEON      1
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(type)  for (uint8_t _atomic = simAtomic(1, (type)); _atomic; _atomic = simAtomic(0, (type)))
+
+#include "../../Libraries/#Core/Timers.h"
+
+#define SIM_TAG 0x80000000UL // Kept in the raw value until the library writes the register
+
+static struct
+{
+	uint64_t cycles;                 // CPU cycles since reset
+	uint64_t start;                  // Cycle the timer was started
+	uint16_t tcnt, ocr, buffer, tccr1a, tccr1b;
+	uint8_t  flags;                  // TIFR
+	uint8_t  blocked, saved;         // Interrupts disabled, state saved by ATOMIC_BLOCK
+	uint8_t  jitter;                 // Random access cost
+	uint32_t raw[SIM_REGISTERS], loaded[SIM_REGISTERS];
+}sim;
+
+static unsigned failures, checks;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+void     check(int condition, const char* text, int line);
+void     simRun(uint32_t cycles);
+void     simInterrupt(void);
+void     simWrite(uint8_t id, uint16_t value);
+void     simClock(void);
+uint16_t simPrescaler(void);
+double   simMicros(void);
+
+int main(void)
+{
+	unsigned long previous, now, first;
+	double        before, after, firstBefore, firstAfter;
+	double        late = 1.0 + TIMER1_PRESCALER * 1000000.0 / F_CPU; // Truncation & the prescaler phase
+	uint32_t      backwards = 0, wrong = 0, inexact = 0;
+	uint64_t      exact;
+
+	// Conversion of counts to us, exact in 32 bits for any count
+	for (uint64_t counts = 0; counts <= 0xFFFFFFFFUL; counts += (counts < 200000) ? 1 : 65521)
+	{
+		exact = counts * TIMER1_PRESCALER * 1000 / ((F_CPU) / 1000);
+		if (TIMER1_toMicros(counts) != (uint32_t)exact)
+			inexact++;
+	}
+	CHECK(inexact == 0);
+
+	// Start: no tick before the first period ended
+	srand(1);
+	TIMER1_begin();
+	simRun(64);
+	CHECK(_timer1Counter == 0);
+	CHECK(micros() < 10);
+	CHECK(sim.ocr == TIMER1_TOP);
+	sim.jitter = 1;
+
+	// micros() never goes backwards and follows the model within the resolution, whatever the ISR latency
+	firstBefore = simMicros();
+	previous    = first = micros();
+	firstAfter  = simMicros();
+	for (uint32_t i = 0; i < 300000; i++)
+	{
+		switch (rand() % 4)
+		{
+			case 0:                                        // ISR delayed by up to a quarter tick
+				sim.blocked = 1;
+				simRun(rand() % (TIMER1_TICK_US * (F_CPU / 1000000UL) / 4));
+				break;
+			case 1:                                        // Interrupts enabled
+				simRun(rand() % 64);
+				break;
+			default:                                       // Back to back calls
+				break;
+		}
+		before = simMicros();
+		now    = micros();
+		after  = simMicros();
+		if (now < previous)
+			backwards++;
+		// TCNT1 is read somewhere inside the call, it lags up to one timer clock and the conversion truncates
+		if ((double)(now - first) > after - firstBefore + late || (double)(now - first) < before - firstAfter - late)
+			wrong++;
+		if ((double)now > after + 1.0 || (double)now < before - late)
+			wrong++;
+		previous = now;
+	}
+	CHECK(backwards == 0);
+	CHECK(wrong == 0);
+	CHECK(_timer1Counter > 1000);
+
+	printf("%lu ticks simulated, %u checks, %u failed\n", (unsigned long)_timer1Counter, checks, failures);
+	return failures != 0;
+}
+
+/*********************************************
+Function: check()
+Purpose:  Count a check and report it when it fails
+Input:    Result, source text, line
+Return:   None
+*********************************************/
+void check(int condition, const char* text, int line)
+{
+	checks++;
+	if (!condition)
+	{
+		failures++;
+		printf("FAIL line %d: %s\n", line, text);
+	}
+}
+
+/*********************************************
+Function: simRegister()
+Purpose:  Apply the writes since the last access, let the access time pass and load the registers
+Input:    Register
+Return:   Raw register the library reads or writes
+*********************************************/
+volatile uint32_t* simRegister(uint8_t id)
+{
+	uint16_t values[SIM_REGISTERS];
+
+	for (uint8_t i = 0; i < SIM_REGISTERS; i++)
+		if (sim.raw[i] != sim.loaded[i])
+			simWrite(i, (uint16_t)sim.raw[i]);
+	simRun(sim.jitter ? 1 + rand() % 16 : 8);
+	values[SIM_TCNT1]  = sim.tcnt;
+	values[SIM_OCR1A]  = sim.buffer;
+	values[SIM_TIFR]   = sim.flags;
+	values[SIM_TCCR1A] = sim.tccr1a;
+	values[SIM_TCCR1B] = sim.tccr1b;
+	for (uint8_t i = 0; i < SIM_REGISTERS; i++)
+		sim.raw[i] = sim.loaded[i] = values[i] | SIM_TAG;
+	return &sim.raw[id];
+}
+
+/*********************************************
+Function: simAtomic()
+Purpose:  ATOMIC_BLOCK entry & exit
+Input:    1 to enter, 0 to leave, ATOMIC_FORCEON or ATOMIC_RESTORESTATE
+Return:   1 to run the block, 0 to leave it
+*********************************************/
+uint8_t simAtomic(uint8_t enter, uint8_t force)
+{
+	if (enter)
+	{
+		sim.saved   = sim.blocked;
+		sim.blocked = 1;
+		return 1;
+	}
+	sim.blocked = force ? 0 : sim.saved;
+	simInterrupt();                                        // A pending interrupt runs right after sei
+	return 0;
+}
+
+/*********************************************
+Function: simRun()
+Purpose:  Let CPU cycles pass, running Timer1 and the compare ISR
+Input:    Cycles
+Return:   None
+*********************************************/
+void simRun(uint32_t cycles)
+{
+	uint16_t prescaler;
+
+	while (cycles--)
+	{
+		sim.cycles++;
+		prescaler = simPrescaler();
+		if (prescaler && sim.cycles % prescaler == 0)
+			simClock();
+		simInterrupt();
+	}
+}
+
+/*********************************************
+Function: simInterrupt()
+Purpose:  Run the compare ISR if it is pending and enabled
+Input:    None
+Return:   None
+*********************************************/
+void simInterrupt(void)
+{
+	if ((sim.flags & (1 << OCF1A)) && (TIMSK & (1 << OCIE1A)) && !sim.blocked)
+	{
+		sim.flags &= ~(1 << OCF1A);                        // Cleared when the ISR starts
+		TIMER1_COMPA_vect();
+	}
+}
+
+/*********************************************
+Function: simWrite()
+Purpose:  Register write side effects
+Input:    Register, value written
+Return:   None
+*********************************************/
+void simWrite(uint8_t id, uint16_t value)
+{
+	uint8_t mode = ((sim.tccr1b >> 1) & 0x0C) | (sim.tccr1a & 0x03);
+
+	switch (id)
+	{
+		case SIM_TCNT1:
+			sim.tcnt = value;
+			break;
+		case SIM_OCR1A:
+			sim.buffer = value;
+			if (mode == 0 || mode == 4 || mode == 12)       // Normal & CTC: not buffered
+				sim.ocr = value;
+			break;
+		case SIM_TIFR:
+			sim.flags &= ~value;                           // Flags are cleared by writing 1
+			break;
+		case SIM_TCCR1A:
+			sim.tccr1a = value;
+			break;
+		case SIM_TCCR1B:
+			if (!simPrescaler() && (value & 0x07))
+				sim.start = sim.cycles;
+			sim.tccr1b = value;
+			break;
+	}
+}
+
+/*********************************************
+Function: simClock()
+Purpose:  One timer clock
+Input:    None
+Return:   None
+*********************************************/
+void simClock(void)
+{
+	uint8_t mode = ((sim.tccr1b >> 1) & 0x0C) | (sim.tccr1a & 0x03);
+
+	if (mode == 15)
+	{
+		if (sim.tcnt == sim.ocr)                           // TOP: restart, load the buffered OCR1A and set OCF1A
+		{
+			sim.tcnt   = 0;
+			sim.ocr    = sim.buffer;
+			sim.flags |= (1 << OCF1A);
+		}
+		else
+			sim.tcnt++;
+	}
+	else
+	{
+		if (sim.tcnt == sim.ocr)                           // Set at the clock after the match
+			sim.flags |= (1 << OCF1A);
+		sim.tcnt++;
+	}
+}
+
+/*********************************************
+Function: simPrescaler()
+Purpose:  Decode the clock select bits
+Input:    None
+Return:   CPU cycles per timer clock, 0 when stopped
+*********************************************/
+uint16_t simPrescaler(void)
+{
+	static const uint16_t prescalers[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+	return prescalers[sim.tccr1b & 0x07];
+}
+
+/*********************************************
+Function: simMicros()
+Purpose:  Exact time since the timer was started
+Input:    None
+Return:   us
+*********************************************/
+double simMicros(void)
+{
+	return (double)(sim.cycles - sim.start) * 1000000.0 / F_CPU;
+}